@@ -4,13 +4,16 @@
 // Stores tables of names for places and transitions as comments
 // Processes inhibitor and priority arcs 
 // Processes transition substitution labels
+// Reads Tina .net textual format as well
 //
 // Usage: NDRtoSN file1.ndr file2.lsn
 //        NDRtoSN file1.ndr file2.hsn
+//        NDRtoSN file1.net file2.lsn
 //
-// Compile: gcc -o NDRtoSN NDRtoSN.c al2.c
-//
-// Uses abstract lists al2.h and al2.c from https://github.com/dazeorgacm/ts
+// Compile: gcc -O2 -o NDRtoSN NDRtoSN.c -lpthread
+// Library, as there is no build system the targets are these lines, API in ndrtosn.h:
+//   static: gcc -O2 -c -DNDRTOSN_LIB NDRtoSN.c -o ndrtosn.o && ar rcs libndrtosn.a ndrtosn.o
+//   shared: gcc -O2 -fPIC -shared -fvisibility=hidden -DNDRTOSN_LIB -o libndrtosn.so NDRtoSN.c -lpthread
 //
 
 #include <stdio.h>
@@ -18,203 +21,133 @@
 #include <string.h>
 #include <malloc.h>
 #include <ctype.h>
+#include <stdint.h>
+#include <stdarg.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <dirent.h>
+#include <time.h>
+#include <sys/resource.h>
+#include <setjmp.h>
 
-#include "al2.h"
-
-void in_l2_tail(struct l2 ** pq, struct l2 * e)
-{
-  struct l2 *e1, *head, *tail;
-
-  if(*pq==NULL) // empty queue
-  {
-    *pq=e;
-    e->next=e;
-    e->prev=e;
-  }
-  else // non empty queuue
-  {
-    head=*pq;
-    tail=head->prev;
-    tail->next=e;
-    e->prev=tail;
-    e->next=head;
-    head->prev=e;
-  }
-} /* in_l2_head */
+#include "ndrtosn.h"
 
-void in_l2_order(struct l2 ** pq, struct l2 * e,int (*compare_content)(void *,void *))
-{
-  struct l2 *curr, *prev, *head;
- 
-  if(*pq==NULL) // empty queue
-  {
-    *pq=e;
-    e->next=e;
-    e->prev=e;
-  }
-  else
-  {
-    curr=*pq;
-    head=*pq;
-    do
-    {
-      if( (*compare_content)(e->content, curr->content) == -1 )
-      {
-        prev=curr->prev;
-        prev->next=e;
-        curr->prev=e;
-        e->prev=prev;
-        e->next=curr;
-        if(curr==head) *pq=e;
-        return;
-      }
-      curr=curr->next;
-    }while(curr!=head);
-    prev=curr->prev;
-    prev->next=e;
-    curr->prev=e;
-    e->prev=prev;
-    e->next=curr;
-  }
-  
-} /* in_l2 */
+#ifndef NDRTOSN_LIB
+#define __MAIN__
+#endif
 
-struct l2 * from_l2_head( struct l2 ** pq )
-{
-  struct l2 *e, *head, *tail;
+//#define MAXINPSTRLEN 16384
+//#define MAXFILENAME 256
+#define FILENAMELEN 256
 
-  if( *pq == NULL ) return NULL; // no elements
+#define nINIT 1024
+#define mINIT 1024
+#define lINIT 1024
+#define atpINIT 2048
+#define aptINIT 2048
+#define attINIT 1024
+#define namesINIT 65536
+#define hidxINIT 4096
+#define obufSIZE (1<<20)
 
-  e=*pq;
-  head=e->next;
-  tail=e->prev;
 
-  if(e == e->next) // 1 element
-  {
-    *pq=NULL;
-  }
-  else // more than 1 elements
-  {
-    *pq=head;
-    head->prev=tail;
-    tail->next=head;
-  } 
-  return e; 
-}/* from_l2_head */
+#define NDR NDRTOSN_NDR
+#define NET NDRTOSN_NET
+#define BLSN NDRTOSN_BLSN
+#define LSN NDRTOSN_LSN
 
-struct l2 * from_l2( struct l2 ** pq, void *sample, int (*find_content)(void *,void *))
-{
-  struct l2 *curr, *head, *prev, *next, *e;
+#define MATR_DENSE NDRTOSN_OUT_DENSE
+#define MATR_SPARSE NDRTOSN_OUT_SPARSE
+#define LSN_BINARY NDRTOSN_OUT_BINARY
+#define MATR_MSN NDRTOSN_OUT_MSN
+#define LSN_GROUPED NDRTOSN_OUT_GROUPED
+#define MATR_CODE NDRTOSN_OUT_CODE
 
-  curr=*pq;
-  head=*pq;
-  e=NULL;
+/* phases of conversion timed in net->ph */
+#define PH_LOAD 0
+#define PH_PARSE 1
+#define PH_HSN 2
+#define PH_CLOSURE 3
+#define PH_WRITE 4
+#define NPHASE 5
 
-  if(curr==NULL) return NULL;
-  
-  do
-  {
-    if( (*find_content)(sample, curr->content) == 1 )
-    {
-      e=curr;
-      break;
-    }
-    curr=curr->next;
-  }while(curr!=head);
-  if(e==NULL) return NULL;
+/* binary LSN: little-endian, sections aligned to 8 bytes */
+#define blsnMAGIC "BLSN"
+#define blsnVERSION 1
+#define blsnHEADER 128
+#define blsnNAMES 1 /* flag: string table present */
 
-  if(e==e->next)
-    *pq=NULL;
-  else
-  {
-    next=e->next;
-    prev=e->prev;
-    prev->next=next;
-    next->prev=prev;
-    if(e==head) *pq=e->next;
-  }
-  return e;
-} /* from_l2 */
+/* state of one conversion: nets are converted concurrently in batch mode */
+struct net {
+  char *str; /* current line */
 
-void print_l2( struct l2 *q, void (*print_content)(void *) )
-{
-  struct l2 * e = q;
-  struct l2 * head = q;
+  int n, m, l, maxn, maxm, maxl; /* net size: trs, pls, labels */
+  int *tn;  /* trs */
+  int *pn;  /* pls */
+  int *mu;  /* marking */
 
-  if(e==NULL)return;
-  do
-  {
-    (*print_content)(e->content);
-    e=e->next;
-  }while(e!=head);
-  printf("\n");
-}/* print_l2 */
+  int *tl, *tltn; /* trs labels */
 
-void print_back_l2( struct l2 *q, void (*print_content)(void *) )
-{
-  struct l2 *e, *tail;
+  char *names; /* all the names: input file tokenized in place */
+  size_t nnames; /* size of input */
+  size_t fnames, maxnames; /* names added after input: fill and capacity, 0 while mapped */
+  int namesmapped;
+  int netname;
 
-  if(e==NULL)return;
-  
-  e = q->prev;
-  tail = q->prev;
+  int *atpp, *atpt, *atpw; /* arcs t->p */
+  int *aptp, *aptt, *aptw; /* arcs p->t */
+  int *att1, *att2;        /* arcs t->t */
+  int fatp, fapt, maxatp, maxapt;
+  int fatt, maxatt;
 
-  do
-  {
-    (*print_content)(e->content);
-    e=e->prev;
-  }while(e!=tail);
-  printf("\n");
-}/* print_back_l2 */
+  int *hidx, maxhidx, fhidx; /* name index: p>0 place, -t<0 transition, 0 empty */
 
+  int *hst, *hnmp, *hsubn, maxhst, nhst; /* HSN substitutions: transition, mapped places, subnet name */
+  int *hmap1, *hmap2, maxhmap, nhmap;    /* HSN place mappings: hp lp */
+  int *pr, maxpr;                        /* transitions of a priority line of .net */
 
-#define __MAIN__
+  size_t netmem, netpeak, nreallocs, reallocbytes; /* net storage accounting */
 
-//#define MAXINPSTRLEN 16384
-//#define MAXFILENAME 256
-#define MAXSTRLEN 1025
-#define FILENAMELEN 256
+  double ph[ NPHASE ];  /* wall time of phases, s */
+  double cpu[ NPHASE ]; /* CPU time of phases with --stats, s */
+  size_t nout;         /* bytes written */
 
-#define nINIT 1024
-#define mINIT 1024
-#define lINIT 1024
-#define atpINIT 2048
-#define aptINIT 2048
-#define attINIT 1024
-#define namesINIT 16384
+  struct ndrtosn_options opt; /* options of conversion */
+  char src[ FILENAMELEN+1 ];  /* name of parsed net */
 
-#define nDELTA 1024
-#define mDELTA 1024
-#define lDELTA 1024
-#define atpDELTA 2048
-#define aptDELTA 2048
-#define attDELTA 512
-#define namesDELTA 8192
+  /* errors: a library call returns by jmp with errcode and message err of context errnet,
+     which is the net itself, or the net flattened for a subnet */
+  struct net * errnet;
+  jmp_buf jmp;
+  int jmpset, errcode;
+  char err[ 2*FILENAMELEN ];
+  struct obuf * out;     /* output open, closed on error */
+  struct subnets * sub;  /* subnets loaded, freed on error */
+  struct pparse * pp;    /* parallel parse, freed on error */
+};
 
-#define NDR 1
-#define NET 2
+static char HSN_prefix[]="{*HSN(";
+static int HSN_prefix_length=6;
 
-static char str[ MAXSTRLEN + 1 ]; /* line buffer */
- 
-static int n, m, l, maxn, maxm, maxl; /* net size: trs, pls, labels */
-static int *tn, fat; /* trs */
-static int *pn, fap; /* pls */
-static int *mu;      /* marking */
+/* error of conversion: within a library call returns from it with code,
+   otherwise prints the message and exits with code */
+void NetError( struct net * net, int code, const char * fmt, ... )
+{
+  va_list ap;
 
-static int *tl, *tltn, fatl; /* trs labels */
- 
-static char *names; /* all the names */
-static int fnames, maxnames;
-static int netname=-1;
- 
-static int *atpp, *atpt, *atpw; /* arcs t->p */
-static int *aptp, *aptt, *aptw; /* arcs p->t */
-static int *att1, *att2;        /* arcs t->t */
-static int fatp, fapt, maxatp, maxapt;
-static int fatt, maxatt;
+  net=net->errnet;
+  va_start( ap, fmt );
+  vsnprintf( net->err, sizeof(net->err), fmt, ap );
+  va_end( ap );
+  net->errcode=code;
+  if( net->jmpset ) longjmp( net->jmp, 1 );
+  printf( "*** %s\n", net->err );
+  exit( code );
 
-static char HSN_prefix[]="{*HSN(";
-static int HSN_prefix_length=6;
+} /* NetError */
 
 void SwallowSpace( char * str, int *i )
 {
@@ -233,715 +166,4788 @@ int IsSpace( char * str, int i )
   
 } /* IsSpace */
 	
-void GetName( int *i, int *j )
+/* scans name at str+(*i) in place, returns its length */
+int ScanName( char * str, int *i )
 {
- int state;
+ int state, i0=(*i);
 
  if( str[(*i)]=='{' )
  {
    state=1;
    while( str[(*i)]!='\0' && state && str[(*i)]!=0xa && str[(*i)]!=0xd ) 
    {
-    names[ (*j)++ ]=str[ (*i)++ ]; 
+    (*i)++; 
     if( str[(*i)-1]=='}' && state==1 ) state=0; else
       if( str[(*i)-1]=='\\' && state==2 ) state=1; else
         if( str[(*i)-1]=='\\' && state==1 ) state=2; else
 	  if( str[(*i)-1]=='}' && state==2 ) state=1; else 
 	    if( state==2 ) state=1;
    }
-   names[ (*j)++ ]='\0';
  }
  else
  {
    while( str[(*i)]!=' ' && str[(*i)]!='\0' && str[(*i)]!=0xa && str[(*i)]!=0xd && str[(*i)]!=0x9 && str[(*i)]!='*' && str[(*i)]!='?')
-    names[ (*j)++ ]=str[ (*i)++ ];
-   names[ (*j)++ ]='\0';
+    (*i)++;
  }
+ return( (*i)-i0 );
+
+} /* ScanName */
 
-} /* GetName */
+/* terminates scanned name in place, the delimiter is consumed */
+void EndName( char * str, int *i )
+{
+  if( str[(*i)]!='\0' ) str[(*i)++]='\0';
 
+} /* EndName */
 
-void ExpandNames()
+/* maps input file, or reads stdin and unmappable files, or copies buffer buf of len bytes, into names terminated by '\0' */
+void LoadInput( struct net * net, char * FileName, char * buf, size_t len )
 {
+  int fd=0;
+  struct stat st;
+  size_t maxin;
+  ssize_t r;
   char * newnames;
 
-  if( fnames+MAXSTRLEN > maxnames )
-  { 
-    maxnames+=namesDELTA;
-    newnames = (char*) realloc( names, maxnames );
-    if( newnames==NULL ) { printf( "*** not enough memory (ExpandNames)\n" ); exit(3); }
-    else names=newnames;
+  net->nnames=0; net->namesmapped=0;
+  if( buf!=NULL )
+  {
+    net->names=(char*) malloc( len+1 );
+    if( net->names==NULL ) NetError( net, 3, "not enough memory (LoadInput)" );
+    memcpy( net->names, buf, len ); net->names[ len ]='\0';
+    net->nnames=len; net->fnames=len+1; net->maxnames=len+1;
+    return;
+  }
+  if( strcmp( FileName, "-" )!=0 )
+  {
+    fd=open( FileName, O_RDONLY );
+    if( fd<0 ) NetError( net, 2, "error open file %s", FileName );
+    /* mapping is private and writable; the rest of the last page keeps the final '\0' */
+    if( fstat( fd, &st )==0 && S_ISREG( st.st_mode ) && st.st_size>0 &&
+        st.st_size % sysconf( _SC_PAGESIZE )!=0 )
+    {
+      net->names=(char*) mmap( NULL, st.st_size, PROT_READ|PROT_WRITE, MAP_PRIVATE, fd, 0 );
+      if( net->names!=MAP_FAILED )
+      {
+        madvise( net->names, st.st_size, MADV_SEQUENTIAL );
+        net->nnames=st.st_size; net->namesmapped=1;
+        net->fnames=net->nnames+1; net->maxnames=0;
+        close( fd );
+        return;
+      }
+    }
+  }
+  maxin=namesINIT;
+  net->names=(char*) malloc( maxin );
+  if( net->names==NULL ) NetError( net, 3, "not enough memory (LoadInput)" );
+  while( ( r=read( fd, net->names+net->nnames, maxin-net->nnames-1 ) ) > 0 )
+  {
+    net->nnames+=r;
+    if( net->nnames+1 >= maxin )
+    {
+      maxin*=2;
+      newnames=(char*) realloc( net->names, maxin );
+      if( newnames==NULL ) NetError( net, 3, "not enough memory (LoadInput)" );
+        else net->names=newnames;
+    }
   }
+  if( r<0 ) NetError( net, 2, "error read file %s", FileName );
+  net->names[ net->nnames ]='\0';
+  net->fnames=net->nnames+1; net->maxnames=maxin;
+  if( fd!=0 ) close( fd );
+
+} /* LoadInput */
+
+void FreeInput( struct net * net )
+{
+  if( net->namesmapped ) munmap( net->names, net->nnames ); else free( net->names );
+  net->names=NULL;
 
-} /* ExpandNames */
+} /* FreeInput */
 
-void ExpandP()
+/* adds name "a.b" after input in names, a is offset in names; returns offset of the name */
+int AddName( struct net * net, int a, char * b )
 {
-  int *newpn, *newmu;
+  size_t la, lb, need, newmax, off;
+  char * newnames;
 
-  if( m >= maxm - 2 ) 
+  la=strlen( net->names+a ); lb=strlen( b );
+  need=net->fnames+la+lb+2;
+  if( need > net->maxnames )
   {
-    maxm+=mDELTA;
-    newpn = (int*) realloc( pn, maxm * sizeof(int) );
-    newmu = (int*) realloc( mu, maxm * sizeof(int) );
-    if( newpn==NULL || newmu==NULL ) 
-      { printf( "*** not enough memory (ExpandP)\n" ); exit(3); }
-    else 
-      { pn=newpn; mu=newmu; }
+    for( newmax=( net->maxnames>0 )? net->maxnames: net->fnames; newmax < need; newmax*=2 );
+    if( net->namesmapped ) /* mapping is replaced by a copy to grow */
+    {
+      newnames=(char*) malloc( newmax );
+      if( newnames!=NULL ) { memcpy( newnames, net->names, net->fnames ); munmap( net->names, net->nnames ); net->namesmapped=0; }
+    }
+    else newnames=(char*) realloc( net->names, newmax );
+    if( newnames==NULL ) NetError( net, 3, "not enough memory (AddName)" );
+    net->names=newnames; net->maxnames=newmax;
   }
+  off=net->fnames;
+  memcpy( net->names+off, net->names+a, la );
+  net->names[ off+la ]='.';
+  memcpy( net->names+off+la+1, b, lb+1 );
+  net->fnames=need;
+  return( off );
+
+} /* AddName */
+
+/* terminates line starting at s in place, returns start of the next line */
+char * NextLine( char * s, char * end, int *len )
+{
+  char * e;
+
+  e=(char*) memchr( s, '\n', end-s );
+  if( e==NULL ) e=end;
+  *e='\0';
+  if( e>s && e[-1]=='\r' ) { e[-1]='\0'; *len=e-s-1; } else *len=e-s;
+  return( e+1 );
+
+} /* NextLine */
+
+double WallTime()
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return( ts.tv_sec + ts.tv_nsec*1e-9 );
+
+} /* WallTime */
+
+/* CPU time of the process */
+double CpuTime()
+{
+  struct timespec ts;
+
+  clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &ts );
+  return( ts.tv_sec + ts.tv_nsec*1e-9 );
+
+} /* CpuTime */
+
+/* ends phase k started at *t0, *c0 and starts the next one; CPU time is taken with --stats only */
+void PhaseEnd( struct net * net, int k, double *t0, double *c0 )
+{
+  double t;
+
+  t=WallTime(); net->ph[k]+=t-*t0; *t0=t;
+  if( net->opt.stats ) { t=CpuTime(); net->cpu[k]+=t-*c0; *c0=t; }
+
+} /* PhaseEnd */
+
+/* allocator of net storage: (re)allocates p of oldsize to newsize bytes */
+void * NetRealloc( struct net * net, void * p, size_t oldsize, size_t newsize, char * who )
+{
+  void * q;
+
+  q=realloc( p, newsize );
+  if( q==NULL && newsize>0 ) NetError( net, 3, "not enough memory (%s)", who );
+  if( p!=NULL ) { net->nreallocs++; net->reallocbytes+=oldsize; }
+  net->netmem+=newsize-oldsize;
+  if( net->netmem>net->netpeak ) net->netpeak=net->netmem;
+  return( q );
+
+} /* NetRealloc */
+
+void NetFree( struct net * net, void * p, size_t size )
+{
+  if( p==NULL ) return;
+  free( p );
+  net->netmem-=size;
+
+} /* NetFree */
+
+/* grows parallel arrays a1, a2, a3 (NULL when not used) of capacity *max geometrically to hold index need */
+void NetGrow( struct net * net, int need, int *max, char * who, int **a1, int **a2, int **a3 )
+{
+  int newmax;
+
+  if( need < *max ) return;
+  newmax=(*max>0)? *max: 1024;
+  while( newmax <= need ) newmax*=2;
+  if( a1!=NULL ) *a1=(int*) NetRealloc( net, *a1, (*max)*sizeof(int), newmax*sizeof(int), who );
+  if( a2!=NULL ) *a2=(int*) NetRealloc( net, *a2, (*max)*sizeof(int), newmax*sizeof(int), who );
+  if( a3!=NULL ) *a3=(int*) NetRealloc( net, *a3, (*max)*sizeof(int), newmax*sizeof(int), who );
+  *max=newmax;
+
+} /* NetGrow */
+
+void ExpandP( struct net * net )
+{
+  NetGrow( net, net->m+2, &net->maxm, "ExpandP", &net->pn, &net->mu, NULL );
 
 } /* ExpandP */
 
-void ExpandT()
+void ExpandT( struct net * net )
 {
-  int *newtn;
+  NetGrow( net, net->n+2, &net->maxn, "ExpandT", &net->tn, NULL, NULL );
 
-  if( n >= maxn - 2 ) 
-  {
-    maxn+=nDELTA;
-    newtn = (int*) realloc( tn, maxn * sizeof(int) );
-    if( newtn==NULL ) 
-      { printf( "*** not enough memory (ExpandT)\n" ); exit(3); }
-    else 
-      { tn=newtn; }
-  }
-  
 } /* ExpandT */
 
-void ExpandTL()
+void ExpandTL( struct net * net )
 {
-  int *newtl, *newtltn;
+  NetGrow( net, net->l+2, &net->maxl, "ExpandTL", &net->tl, &net->tltn, NULL );
 
-  if( l >= maxl - 2 ) 
-  {
-    maxl+=lDELTA;
-    newtl = (int*) realloc( tl, maxl * sizeof(int) );
-    newtltn = (int*) realloc( tltn, maxl * sizeof(int) );
-    if( newtl==NULL || newtltn==NULL ) 
-      { printf( "*** not enough memory (ExpandTL)\n" ); exit(3); }
-    else 
-      { tl=newtl; tltn=newtltn; }
-  }
-  
 } /* ExpandTL */
 
-void ExpandAtp()
+void ExpandAtp( struct net * net )
+{
+  NetGrow( net, net->fatp, &net->maxatp, "ExpandAtp", &net->atpp, &net->atpt, &net->atpw );
+
+} /* ExpandAtp */
+
+void ExpandApt( struct net * net )
+{
+  NetGrow( net, net->fapt, &net->maxapt, "ExpandApt", &net->aptp, &net->aptt, &net->aptw );
+
+} /* ExpandApt */
+
+void ExpandAtt( struct net * net )
+{
+  NetGrow( net, net->fatt, &net->maxatt, "ExpandAtt", &net->att1, &net->att2, NULL );
+
+} /* ExpandAtt */
+
+/* estimates net size by a quick count of line types in the input */
+void EstimateNet( struct net * net, int format, int *em, int *en, int *eapt, int *eatp, int *eatt )
 {
-  int *newatpp, *newatpt, *newatpw;
+  char *s, *e, *q, *end;
+  int side, ne=0;
 
-  if( fatp>=maxatp ) 
+  *em=0; *en=0; *eapt=0; *eatp=0; *eatt=0;
+  s=net->names; end=net->names+net->nnames;
+  while( s < end )
   {
-    maxatp+=atpDELTA;
-    newatpp = (int*) realloc( atpp, maxatp * sizeof(int) );
-    newatpt = (int*) realloc( atpt, maxatp * sizeof(int) );
-    newatpw = (int*) realloc( atpw, maxatp * sizeof(int) );
-    if( newatpp==NULL || newatpt==NULL || newatpw==NULL )
-      { printf( "*** not enough memory (ExpandAtp)\n" ); exit(3); }
-    else 
-      { atpp=newatpp; atpt=newatpt; atpw=newatpw; }
+    e=(char*) memchr( s, '\n', end-s );
+    if( e==NULL ) e=end;
+    while( s<e && ( *s==' ' || *s=='\t' ) ) s++;
+    if( format==NDR )
+    {
+      if( *s=='p' ) (*em)++; else
+        if( *s=='t' ) (*en)++; else
+          if( *s=='e' ) ne++;
+    }
+    else if( e-s>2 && ( s[0]=='t' || s[0]=='p' ) && ( s[1]=='r' || s[1]=='l' ) )
+    {
+      if( s[1]=='l' ) (*em)++; else if( s[0]=='t' ) (*en)++;
+      side=0;
+      for( q=s+3; q<e; q++ ) /* arcs are tokens after the name */
+        if( ! isspace( *q ) && isspace( q[-1] ) )
+        {
+          if( q[0]=='-' && q[1]=='>' ) side=1; else
+            if( s[0]=='p' && s[1]=='r' ) (*eatt)++; else
+              if( side ) (*eatp)++; else (*eapt)++;
+        }
+    }
+    s=e+1;
   }
+  if( format==NDR ) { *eapt=ne/2; *eatp=ne/2; }
 
-} /* ExpandAtp */
+} /* EstimateNet */
+
+/* FNV-1a hash of a name given by its first len characters */
+unsigned HashName( char * s, int len )
+{
+  unsigned h=2166136261u;
+  int i;
+
+  for( i=0; i<len; i++ ) { h^=(unsigned char)s[i]; h*=16777619u; }
+  return( h );
+
+} /* HashName */
+
+char * NodeName( struct net * net, int node )
+{
+  return( net->names + ( (node>0)? net->pn[node]: net->tn[-node] ) );
+
+} /* NodeName */
 
-void ExpandApt()
+/* returns place p>0, transition -t<0, or 0 when name is unknown */
+int FindName( struct net * net, char * s, int len )
 {
-  int *newaptp, *newaptt, *newaptw;
+  unsigned h;
+  char * nm;
 
-  if( fapt>=maxapt ) 
+  h=HashName( s, len ) & (net->maxhidx-1);
+  while( net->hidx[h]!=0 )
   {
-    maxapt+=aptDELTA;
-    newaptp = (int*) realloc( aptp, maxapt * sizeof(int) );
-    newaptt = (int*) realloc( aptt, maxapt * sizeof(int) );
-    newaptw = (int*) realloc( aptw, maxapt * sizeof(int) );
-    if( newaptp==NULL || newaptt==NULL || newaptw==NULL )
-      { printf( "*** not enough memory (ExpandApt)\n" ); exit(3); }
-    else 
-      { aptp=newaptp; aptt=newaptt; aptw=newaptw; }
+    nm=NodeName( net, net->hidx[h] );
+    if( strncmp( nm, s, len )==0 && nm[len]=='\0' ) return( net->hidx[h] );
+    h=(h+1) & (net->maxhidx-1);
   }
+  return( 0 );
 
-} /* ExpandApt */
+} /* FindName */
+
+void ExpandHidx( struct net * net )
+{
+  int *oldhidx, oldmax, i;
+  unsigned h;
+  char * nm;
+
+  if( 2*(net->fhidx+1) <= net->maxhidx ) return;
+  oldhidx=net->hidx; oldmax=net->maxhidx;
+  net->maxhidx*=2;
+  net->hidx = (int*) NetRealloc( net, NULL, 0, net->maxhidx*sizeof(int), "ExpandHidx" );
+  memset( net->hidx, 0, net->maxhidx*sizeof(int) );
+  for( i=0; i<oldmax; i++ )
+    if( oldhidx[i]!=0 )
+    {
+      nm=NodeName( net, oldhidx[i] );
+      h=HashName( nm, strlen(nm) ) & (net->maxhidx-1);
+      while( net->hidx[h]!=0 ) h=(h+1) & (net->maxhidx-1);
+      net->hidx[h]=oldhidx[i];
+    }
+  NetFree( net, oldhidx, oldmax*sizeof(int) );
 
-void ExpandAtt()
+} /* ExpandHidx */
+
+/* adds node (p>0 or -t<0) with name of len characters to index, returns 0 or the node already having this name */
+int IndexName( struct net * net, int node, int len )
 {
-  int *newatt1, *newatt2;
+  unsigned h;
+  char * nm, * s;
 
-  if( fatt>=maxatt ) 
+  ExpandHidx( net );
+  s=NodeName( net, node );
+  h=HashName( s, len ) & (net->maxhidx-1);
+  while( net->hidx[h]!=0 )
   {
-    maxatt+=attDELTA;
-    newatt1 = (int*) realloc( att1, maxatt * sizeof(int) );
-    newatt2 = (int*) realloc( att2, maxatt * sizeof(int) );
-    if( newatt1==NULL || newatt2==NULL )
-      { printf( "*** not enough memory (ExpandAtt)\n" ); exit(3); }
-    else 
-      { att1=newatt1; att2=newatt2; }
+    nm=NodeName( net, net->hidx[h] );
+    if( strncmp( nm, s, len )==0 && nm[len]=='\0' ) return( net->hidx[h] );
+    h=(h+1) & (net->maxhidx-1);
   }
+  net->hidx[h]=node; net->fhidx++;
+  return( 0 );
 
-} /* ExpandAtt */
+} /* IndexName */
 
-void ReadNDR( FILE * f )
+/* registers label of len characters at names+ii of transition t if it is a substitution label */
+void TransitionLabel( struct net * net, int t, int ii, int len )
 {
- int i, found, p, t, inames, len, w, mup, tt, ii;
- char *name1, *name2;
+	if(len>=HSN_prefix_length+2 && memcmp(HSN_prefix,net->names+ii,HSN_prefix_length)==0)
+	{
+//printf("%d %s\n",t,names+ii);
+	   ExpandTL( net );
+           net->tl[ ++net->l ]=ii+HSN_prefix_length; net->tltn[ net->l ]=t;
+           net->names[ii+len-2]='\0';
+	}
+
+} /* TransitionLabel */
+
+void ReadNDR( struct net * net )
+{
+ int i, p, len, w, mup, ii, node1, node2, len1, len2, lenn;
+ char *name1, *name2, *s, *end;
 
- m=0; n=0; l=0;
- while( ! feof( f ) )
+ net->m=0; net->n=0; net->l=0;
+ s=net->names; end=net->names+net->nnames;
+ while( s < end )
  {
-   ExpandNames();
-      
-   fgets( str, MAXSTRLEN, f ); 
-   if( feof(f) ) break;
-   if( str[0]=='#' ) continue; /* comment line */
+   net->str=s;
+   s=NextLine( s, end, &len );
+   if( net->str[0]=='#' ) continue; /* comment line */
    
-   len=strlen(str); i=0;
-   SwallowSpace( str, &i );
+   i=0;
+   SwallowSpace( net->str, &i );
    if( i==len ) continue; /*empty line */
    
-   switch( str[i++] )
+   switch( net->str[i++] )
    {
      case 'p':
-     	SwallowSpace( str, &i );
-	while( ! IsSpace( str,i) && i<len )i++; /* x */
-	SwallowSpace( str, &i );
-	while( ! IsSpace( str,i) && i<len )i++; /* y */
-	SwallowSpace( str, &i );
-	ExpandP();
-	pn[ ++m ] = fnames;
-	mu[ m ] = 0;
-	GetName( &i, &fnames );
-	found=0;
-	for( p=1; p<m; p++ )
-	  if( strcmp( names+pn[p], names+pn[m] )==0 ) { found=1; break; }
-	if( ! found )
-	{  
-	  p=m;
-	  for( t=1; t<=n; t++ )
-	      if( strcmp( names+tn[t], names+pn[m] )==0 ) { found=1; break; }
-	}
-	if( found ) { printf( "*** duplicate name: %s\n", names+pn[m] ); exit(2); }
+     	SwallowSpace( net->str, &i );
+	while( ! IsSpace( net->str,i) && i<len )i++; /* x */
+	SwallowSpace( net->str, &i );
+	while( ! IsSpace( net->str,i) && i<len )i++; /* y */
+	SwallowSpace( net->str, &i );
+	ExpandP( net );
+	net->pn[ ++net->m ] = net->str+i-net->names;
+	net->mu[ net->m ] = 0;
+	lenn=ScanName( net->str, &i );
+	EndName( net->str, &i );
+	p=net->m;
+	if( IndexName( net, p, lenn ) ) NetError( net, 2, "duplicate name: %s", net->names+net->pn[net->m] );
 	
 	/* marking */
-	SwallowSpace( str, &i );
-        mup=atoi( str+i );
-        mu[ p ]=mup;	  
+	SwallowSpace( net->str, &i );
+        mup=atoi( net->str+i );
+        net->mu[ p ]=mup;	  
 	break;
 	
      case 't':
-       	SwallowSpace( str, &i );
-	while( ! IsSpace( str,i) && i<len )i++; /* xpos */
-	SwallowSpace( str, &i );
-	while( ! IsSpace( str,i) && i<len )i++; /* ypos */
-	SwallowSpace( str, &i );
-	ExpandT();
-	tn[ ++n ] = fnames;
-	GetName( &i, &fnames );
-	found=0;
-	for( p=1; p<=m; p++ )
-	  if( strcmp( names+pn[p], names+tn[n] )==0 ) { found=1; break; }
-	if( ! found )
-	{  
-	  for( t=1; t<n; t++ )
-	      if( strcmp( names+tn[t], names+tn[n] )==0 ) { found=1; break; }
-	}
-	if( found ) { printf( "*** duplicate name: %s\n", names+tn[n] ); exit(2); }
+       	SwallowSpace( net->str, &i );
+	while( ! IsSpace( net->str,i) && i<len )i++; /* xpos */
+	SwallowSpace( net->str, &i );
+	while( ! IsSpace( net->str,i) && i<len )i++; /* ypos */
+	SwallowSpace( net->str, &i );
+	ExpandT( net );
+	net->tn[ ++net->n ] = net->str+i-net->names;
+	lenn=ScanName( net->str, &i );
+	EndName( net->str, &i );
+	if( IndexName( net, -net->n, lenn ) ) NetError( net, 2, "duplicate name: %s", net->names+net->tn[net->n] );
 	// tuta1
-	SwallowSpace( str, &i );
-	while( ! IsSpace( str,i) && i<len )i++; /* anchor */
-	SwallowSpace( str, &i );
-	while( ! IsSpace( str,i) && i<len )i++; /* eft */
-	SwallowSpace( str, &i );
-	while( ! IsSpace( str,i) && i<len )i++; /* lft */
-	SwallowSpace( str, &i );
-	while( ! IsSpace( str,i) && i<len )i++; /* anchor */
-	SwallowSpace( str, &i );
-	ii=fnames;
-	GetName( &i, &fnames );
-	if(memcmp(HSN_prefix,names+ii,HSN_prefix_length)==0)
-	{
-//printf("%d %s\n",n,names+ii);
-	   ExpandTL();
-           tl[ ++l ]=ii+HSN_prefix_length; tltn[ l ]=n;
-           names[fnames-3]='\0';
-           fnames-=2;         
-	}
+	SwallowSpace( net->str, &i );
+	while( ! IsSpace( net->str,i) && i<len )i++; /* anchor */
+	SwallowSpace( net->str, &i );
+	while( ! IsSpace( net->str,i) && i<len )i++; /* eft */
+	SwallowSpace( net->str, &i );
+	while( ! IsSpace( net->str,i) && i<len )i++; /* lft */
+	SwallowSpace( net->str, &i );
+	while( ! IsSpace( net->str,i) && i<len )i++; /* anchor */
+	SwallowSpace( net->str, &i );
+	ii=net->str+i-net->names;
+	lenn=ScanName( net->str, &i );
+	TransitionLabel( net, net->n, ii, lenn );
 	break;
       
      case 'e':
-	SwallowSpace( str, &i );
-	inames=fnames;
-	name1=names+inames;
-	GetName( &i, &inames );
-	SwallowSpace( str, &i );
-	if( isdigit(str[i])) while( ! IsSpace( str,i) && i<len )i++; /* rad */
-	SwallowSpace( str, &i );
-	if( isdigit(str[i])) while( ! IsSpace( str,i) && i<len )i++; /* ang */
-	SwallowSpace( str, &i );
-	name2=names+inames;
-	GetName( &i, &inames );
+	SwallowSpace( net->str, &i );
+	name1=net->str+i;
+	len1=ScanName( net->str, &i );
+	SwallowSpace( net->str, &i );
+	if( isdigit(net->str[i])) while( ! IsSpace( net->str,i) && i<len )i++; /* rad */
+	SwallowSpace( net->str, &i );
+	if( isdigit(net->str[i])) while( ! IsSpace( net->str,i) && i<len )i++; /* ang */
+	SwallowSpace( net->str, &i );
+	name2=net->str+i;
+	len2=ScanName( net->str, &i );
 	/* start from end */
-	i=strlen( str )-1;
-	while( IsSpace( str,i) && i>0 )i--; 
-	while( ! IsSpace( str,i) && i>0 )i--; /* anchor */
-	while( IsSpace( str,i) && i>0 )i--;
-	while( ! IsSpace( str,i) && i>0 )i--; /* weight */
-	w=atoi( str+i+1 ); /* multiplicity */
+	i=len-1;
+	while( IsSpace( net->str,i) && i>0 )i--; 
+	while( ! IsSpace( net->str,i) && i>0 )i--; /* anchor */
+	while( IsSpace( net->str,i) && i>0 )i--;
+	while( ! IsSpace( net->str,i) && i>0 )i--; /* weight */
+	w=atoi( net->str+i+1 ); /* multiplicity */
 		
 	/* recognize arc */
 	
-	if( fapt>=maxapt || fatp>=maxatp ) { ExpandAtp(); ExpandApt(); }
+	if( net->fapt>=net->maxapt || net->fatp>=net->maxatp ) { ExpandAtp( net ); ExpandApt( net ); }
 	
-	found=0;
-	for( p=1; p<=m; p++ )
-	  if( strcmp( names+pn[p], name1 )==0 ) { ExpandApt(); aptp[fapt]=p; found=1; break; }
-	if( found )
+	node1=FindName( net, name1, len1 );
+	node2=FindName( net, name2, len2 );
+	if( node1>0 && node2<0 )
+	{
+	  ExpandApt( net ); net->aptp[net->fapt]=node1; net->aptw[net->fapt]=w; net->aptt[net->fapt++]=-node2;
+	}
+	else if( node1<0 && node2>0 )
 	{
-	  found=0;
-	  for( t=1; t<=n; t++ )
-	    if( strcmp( names+tn[t], name2 )==0 ) { aptw[fapt]=w; aptt[fapt++]=t; found=1; break; }
-	  if( ! found ) { printf( "*** unknown arc: %s -> %s\n", name1, name2 ); exit(2); }
+	  ExpandAtp( net ); net->atpt[net->fatp]=-node1; net->atpw[net->fatp]=w; net->atpp[net->fatp++]=node2;
 	}
-	else
-	{	
-	  found=0;
-	  for( t=1; t<=n; t++ )
-	    if( strcmp( names+tn[t], name1 )==0 ) { found=1; break; }
-	  if( ! found ) { printf( "*** unknown arc: %s -> %s\n", name1, name2 ); exit(2); }
-	  found=0;
-	  for( p=1; p<=m; p++ )
-	    if( strcmp( names+pn[p], name2 )==0 ) { ExpandAtp(); atpt[fatp]=t;
-	                                            atpw[fatp]=w; atpp[fatp++]=p; found=1; break; }
-	  if( ! found )
-	  {
-	    found=0;
-	    for( tt=1; tt<=n; tt++ ) // tuta
-	      if( strcmp( names+tn[tt], name2 )==0 ) { // printf("tt: %d->%d\n",t,tt);
-	                                               ExpandAtt(); att1[fatt]=t;
-	                                               att2[fatt++]=tt; found=1; break; }
-	    if( ! found ) { printf( "*** unknown arc: %s -> %s\n", name1, name2 ); exit(2); }
-	  }
+	else if( node1<0 && node2<0 )
+	{
+	  ExpandAtt( net ); net->att1[net->fatt]=-node1; net->att2[net->fatt++]=-node2;
 	}
+	else NetError( net, 2, "unknown arc: %.*s -> %.*s", len1, name1, len2, name2 );
 	break;
      
      case 'h':
-       SwallowSpace( str, &i );
-       netname = fnames;
-       GetName( &i, &fnames );
+       SwallowSpace( net->str, &i );
+       net->netname = net->str+i-net->names;
+       ScanName( net->str, &i );
+       EndName( net->str, &i );
        break;
 	
    } /* switch */    
  } /* while */
 }/* ReadNDR */
 
-void WriteNMP( FILE * f )
+/* reads number with optional K or M multiplier */
+int GetNum( char * str, int *i )
 {
-  int p; 
-  
-  for( p=1; p<=m; p++ )
-  {
-    fprintf( f, "; %d %s\n", p, names + pn[p]  );
-  }
+  int x;
 
-}/* WriteNMP */
+  x=atoi( str+(*i) );
+  if( str[(*i)]=='-' || str[(*i)]=='+' ) (*i)++;
+  while( isdigit( str[(*i)] ) ) (*i)++;
+  if( str[(*i)]=='K' ) { x*=1000; (*i)++; } else
+    if( str[(*i)]=='M' ) { x*=1000000; (*i)++; }
+  return( x );
 
-void WriteNMT( FILE * f )
+} /* GetNum */
+
+/* finds or creates place (kind>0) or transition (kind<0) named at str+(*i), the name is not terminated */
+int GetNode( struct net * net, int *i, int kind )
 {
-  int t; 
-  
-  for( t=1; t<=n; t++ )
+  int i0, len, node;
+
+  i0=(*i);
+  len=ScanName( net->str, i );
+  node=FindName( net, net->str+i0, len );
+  if( node!=0 )
   {
-    fprintf( f, "; %d %s\n", t, names + tn[t] );
+    if( (node>0) != (kind>0) ) NetError( net, 2, "name of both place and transition: %.*s", len, net->str+i0 );
+    return( node );
   }
+  if( kind>0 ) { ExpandP( net ); net->pn[ ++net->m ]=net->str+i0-net->names; net->mu[ net->m ]=0; node=net->m; }
+  else { ExpandT( net ); net->tn[ ++net->n ]=net->str+i0-net->names; node=-net->n; }
+  IndexName( net, node, len );
+  return( node );
 
-}/* WriteNMT */
-
-struct pl_sub {
-  char * cptype;
-  char * cphnam;
-  char * cplnum;
-};
+} /* GetNode */
 
-void ProcessHSNlabels( FILE * f )
+/* reads arc weight suffix of name ending at str+(*i) into *w: *w with w>=1, ?-1 (inhibitor, weight 0) on input arcs
+   only, out for arcs t->p; returns NULL or format of error message for the line */
+char * ArcWeight( char * str, int *i, int out, int *w )
 {
-  int i,j,t,isubn,cptype,cphname,cplnum,pst,hp,lp,v1,v2,p,found;
-  struct l2 * qq=NULL;
-  struct l2 * el2;
-  struct pl_sub * e;
-  
-  for(j=1;j<=l;j++)
+  *w=1;
+  if( str[(*i)]=='*' )
   {
-    // tuta3
-    t=tltn[ j ];
-    strcpy(str,names+tl[ j ]);
-//fprintf( f, "%s\n", str );
-    i=0;
-    SwallowSpace(str,&i);
-    isubn=fnames;
-    GetName(&i,&fnames);   
-//printf("substitute transition %d (%s) by subnet %s\n", t, names+tl[ j ], names+isubn );
-    pst=0;
-    // reset queue
-    while(str[i]!='\0')
-    {
-      SwallowSpace(str,&i);
-      cptype=fnames;
-      GetName(&i,&fnames);
-      SwallowSpace(str,&i);
-      cphname=fnames;
-      GetName(&i,&fnames);
-      SwallowSpace(str,&i);
-      cplnum=fnames;
-      GetName(&i,&fnames);
-//printf("place type %s name %s merged with %s\n",names+cptype,names+cphname,names+cplnum);
-      e=malloc(sizeof(struct pl_sub));
-      if(e==NULL) {printf("karaul e!\n"); exit(13);}
-      e->cptype=names+cptype;
-      e->cphnam=names+cphname;
-      e->cplnum=names+cplnum;
-      el2=malloc(sizeof(struct l2));
-      if(el2==NULL) {printf("karaul el2!\n"); exit(13);}
-      el2->content=(void *)e;
-      in_l2_tail(&qq,el2 );
-      pst++;
-      // add to queue and increment counter
-    }
-    fprintf( f, "; HSN substitution transition: t nmp subnet\n"); 
-    fprintf(f,"%d %d %s\n",t,pst,names+isubn); 
-    fprintf( f, "; HSN place mapping: hp lp\n"); 
-    while((el2=from_l2_head( &qq ))!=NULL) 
-    {
-      e=(struct pl_sub *)el2->content;
-      found=0;
-//printf("mapping: %s\n",e->cphnam);
-	for( p=1; p<=m; p++ )
-	  if( strcmp( names+pn[p], e->cphnam )==0 ) { found=1; hp=p; break; }
-	  //else printf("other name: %s\n",names+pn[p]);
-      if(found==0)
-      {
-        printf("*** error: invalid HSN label place name %s\n",e->cphnam);
-        exit(3);
-      }
-      lp=atoi(e->cplnum);
-      if(strcmp(e->cptype,"i")==0)
-      {
-        v1=hp; v2=lp;
-      }
-      else if(strcmp(e->cptype,"o")==0)
-      {
-        v1=hp; v2=-lp;
-      }
-      else if(strcmp(e->cptype,"s")==0)
-      {
-        v1=-hp; v2=lp;
-      }
-      else if(strcmp(e->cptype,"f")==0)
-      {
-        v1=-hp; v2=-lp;
-      } 
-      else
-      {
-        printf("*** error: invalid HSN label place type %s\n",e->cptype);
-        exit(3);
-      }
-      fprintf(f,"%d %d\n",v1,v2);
-      free(e); 
-      free(el2);
-    }
-    
-    // print ht np <subnet>
-    // print queue hp  lp
-    // free queue
-    
+    (*i)++; *w=GetNum( str, i );
+    if( *w<1 ) return( "unsupported arc: %s" );
   }
-}/* ProcessHSNlabels */
-
-void WriteLSN( FILE * f )
-{
-  int i, p, nnmu=0; 
-  
-  for( p=1; p<=m; p++ )
-    if(mu[p]>0) nnmu++;
-  
-  fprintf( f, "; LSN obtained from NDR\n");
-  fprintf( f, "; m n narcs nnmu, nst\n");
-  fprintf( f, "%d %d %d %d %d\n", m, n, fapt+fatp+fatt, nnmu, l );
-  
-  fprintf( f, "; p->t: p t w\n");
-  for( i=0; i<fapt; i++ )
-    fprintf( f, "%d %d %d\n", aptp[i], aptt[i], (aptw[i]>0)?aptw[i]:-1 );
-  
-  fprintf( f, "; t->p: -p t w\n");  
-  for( i=0; i<fatp; i++ )
-    fprintf( f, "%d %d %d\n", -atpp[i], atpt[i], atpw[i] );
-  
-  fprintf( f, "; t->t: -t1 -t2 0\n");    
-  for( i=0; i<fatt; i++ )
-    fprintf( f, "%d %d %d\n", -att1[i], -att2[i], 0 );
-    
-  fprintf( f, "; mu(p):\n");
-  for( p=1; p<=m; p++ )
-    if(mu[p]>0) fprintf( f, "%d %d\n", p, mu[p] );
-      
-  if(l>0) 
+  else if( str[(*i)]=='?' )
   {
-     ProcessHSNlabels( f );
+    (*i)++;
+    if( out ) return( "unsupported arc: %s" );
+    if( str[(*i)]=='-' ) { (*i)++; *w=GetNum( str, i ); }
+      else *w=-1;
+    if( *w!=1 ) return( "unsupported test or inhibitor arc: %s" );
+    *w=0;
   }
-  
-  fprintf( f, "; Table of places\n; no name\n");
-  WriteNMP( f );
-  
-  fprintf( f, "; Table of transitions\n; no name\n");
-  WriteNMT( f );
-  
-  fprintf( f, "; end of LSN\n");
+  else if( ! IsSpace( str, (*i) ) ) return( "unsupported arc: %s" );
+  return( NULL );
 
-}/* WriteLSN */
+} /* ArcWeight */
 
-void WriteNMP_matr_h( FILE * f )
+int GetArcWeight( struct net * net, int *i, int out )
 {
-  int p; 
-  
-  for( p=1; p<=m; p++ )
-  {
-    fprintf( f, "// %d\t%s\n", p-1, names + pn[p]  );
-  }
+  int w;
+  char * e;
 
-}/* WriteNMP_matr_h */
+  if( ( e=ArcWeight( net->str, i, out, &w ) )!=NULL ) NetError( net, 2, e, net->str );
+  return( w );
 
-void WriteNMT_matr_h( FILE * f )
+} /* GetArcWeight */
+
+/* reads arcs "inputs -> outputs" of node (p>0 or -t<0) */
+void GetArcs( struct net * net, int *i, int node )
+{
+  int side=0, x, w, e;
+
+  while( 1 )
+  {
+    SwallowSpace( net->str, i );
+    if( net->str[(*i)]=='\0' ) break;
+    if( net->str[(*i)]=='-' && net->str[(*i)+1]=='>' ) { (*i)+=2; side=1; continue; }
+    x=GetNode( net, i, -node );
+    e=(*i);
+    w=GetArcWeight( net, i, ( node<0 )==side );
+    /* name is terminated after its weight suffix is read */
+    if( net->str[e]!='\0' ) { net->str[e]='\0'; if( (*i)==e ) (*i)++; }
+    if( node<0 && side==0 ) { ExpandApt( net ); net->aptp[net->fapt]=x; net->aptw[net->fapt]=w; net->aptt[net->fapt++]=-node; }
+    else if( node<0 && side==1 ) { ExpandAtp( net ); net->atpt[net->fatp]=-node; net->atpw[net->fatp]=w; net->atpp[net->fatp++]=x; }
+    else if( node>0 && side==0 ) { ExpandAtp( net ); net->atpt[net->fatp]=-x; net->atpw[net->fatp]=w; net->atpp[net->fatp++]=node; }
+    else { ExpandApt( net ); net->aptp[net->fapt]=node; net->aptw[net->fapt]=w; net->aptt[net->fapt++]=-x; }
+  }
+
+} /* GetArcs */
+
+void ReadNET( struct net * net )
+{
+ int i, len, t, p, ii, npr, k, h;
+ char *kw, *s, *end;
+
+ net->m=0; net->n=0; net->l=0;
+ s=net->names; end=net->names+net->nnames;
+ while( s < end )
+ {
+   net->str=s;
+   s=NextLine( s, end, &len );
+   i=0;
+   SwallowSpace( net->str, &i );
+   if( i==len || net->str[i]=='#' ) continue; /* empty or comment line */
+   kw=net->str+i;
+   while( ! IsSpace( net->str,i) ) i++;
+   SwallowSpace( net->str, &i );
+
+   if( memcmp( kw, "tr", 2 )==0 && IsSpace( kw, 2 ) )
+   {
+     t=-GetNode( net, &i, -1 );
+     EndName( net->str, &i );
+     SwallowSpace( net->str, &i );
+     if( net->str[i]==':' ) /* label */
+     {
+       i++;
+       SwallowSpace( net->str, &i );
+       ii=net->str+i-net->names;
+       k=ScanName( net->str, &i );
+       TransitionLabel( net, t, ii, k );
+       SwallowSpace( net->str, &i );
+     }
+     if( net->str[i]=='[' || net->str[i]==']' ) /* interval */
+     {
+       i++;
+       while( net->str[i]!='\0' && net->str[i]!='[' && net->str[i]!=']' ) i++;
+       if( net->str[i]!='\0' ) i++;
+     }
+     GetArcs( net, &i, -t );
+   }
+   else if( memcmp( kw, "pl", 2 )==0 && IsSpace( kw, 2 ) )
+   {
+     p=GetNode( net, &i, 1 );
+     EndName( net->str, &i );
+     SwallowSpace( net->str, &i );
+     if( net->str[i]==':' ) /* label */
+     {
+       i++;
+       SwallowSpace( net->str, &i );
+       ScanName( net->str, &i );
+       SwallowSpace( net->str, &i );
+     }
+     if( net->str[i]=='(' ) /* marking */
+     {
+       i++;
+       net->mu[ p ]=GetNum( net->str, &i );
+       if( net->str[i]==')' ) i++;
+     }
+     GetArcs( net, &i, p );
+   }
+   else if( memcmp( kw, "pr", 2 )==0 && IsSpace( kw, 2 ) )
+   {
+     npr=0; h=0; k=0; /* names before relation: pr[0..h-1], k=1 for '>', k=-1 for '<' */
+     while( 1 )
+     {
+       SwallowSpace( net->str, &i );
+       if( net->str[i]=='\0' ) break;
+       if( net->str[i]=='>' || net->str[i]=='<' ) { h=npr; k=(net->str[i]=='>')? 1: -1; i++; continue; }
+       NetGrow( net, npr, &net->maxpr, "ReadNET", &net->pr, NULL, NULL );
+       net->pr[ npr++ ]=-GetNode( net, &i, -1 );
+       EndName( net->str, &i );
+     }
+     if( k==0 ) NetError( net, 2, "invalid priority: %s", kw );
+     for( t=0; t<h; t++ )
+       for( ii=h; ii<npr; ii++ )
+       {
+         ExpandAtt( net );
+         if( k>0 ) { net->att1[net->fatt]=net->pr[t]; net->att2[net->fatt++]=net->pr[ii]; }
+           else { net->att1[net->fatt]=net->pr[ii]; net->att2[net->fatt++]=net->pr[t]; }
+       }
+   }
+   else if( memcmp( kw, "net", 3 )==0 && IsSpace( kw, 3 ) )
+   {
+     net->netname = net->str+i-net->names;
+     ScanName( net->str, &i );
+     EndName( net->str, &i );
+   }
+ } /* while */
+}/* ReadNET */
+
+/* parallel parse of .ndr and .net: the input is split at line boundaries into chunks, which threads tokenize
+   into mentions of names, candidate nodes and arcs; candidates are indexed concurrently in hidx, where the
+   earliest one of a name wins, winners are numbered in file order, and the mentions are resolved in a second
+   parallel pass; the earliest error in file order is reported, so net and errors are those of ReadNDR/ReadNET */
+
+#ifndef PARSE_CHUNK
+#define PARSE_CHUNK (1<<20) /* bytes of input at least per thread */
+#endif
+
+#define PA_APT 0 /* arcs: p->t, t->p, t->t, and .ndr arc between names */
+#define PA_ATP 1
+#define PA_ATT 2
+#define PA_ANY 3
+
+#define PP_TOKENS 0 /* phases of parallel parse */
+#define PP_INDEX 1
+#define PP_COUNT 2
+#define PP_NUMBER 3
+#define PP_RESOLVE 4
+#define PP_ARCS 5
+
+struct pref {    /* mention of name at offset pos: kind 1 place, -1 transition, 0 any (.ndr arc); node after resolution */
+  int name, len, kind, pos, def, node;
+};
+
+struct pcand {   /* candidate node: definition in .ndr, first mention in chunk in .net */
+  int name, len, kind, pos, mu;
+};
+
+struct parc {    /* arc of type PA_* between mentions r1 and r2, nodes after resolution */
+  int type, r1, r2, w;
+};
+
+struct pset {    /* marking x (len<0) or label at x of len characters of mention r */
+  int r, x, len;
+};
+
+struct pchunk {
+  char *s, *end;
+  struct pref *ref; int nref, maxref;
+  struct pcand *cand; int ncand, maxcand;
+  struct parc *arc; int narc, maxarc;
+  struct pset *set; int nset, maxset;
+  int *pr, maxpr;  /* names of priority line */
+  int netname;
+  int coff, np, nt, poff, toff, na[3], aoff[3];
+  int errpos, errcode;
+  char err[ 2*FILENAMELEN ];
+};
+
+struct pjob {
+  struct pparse * pp;
+  int id;
+};
+
+struct pparse {
+  struct net * net;
+  int format, nc, phase, ncand;
+  struct pchunk * c;
+  struct pjob * job;
+  pthread_t * th;
+  struct pcand * gc; /* candidates of all chunks */
+  int * gnode;       /* node of candidate, 0 if it is not the first of its name */
+};
+
+/* keeps the earliest error of chunk, at pos -1 errors of memory */
+void PError( struct pchunk * c, int pos, int code, const char * fmt, ... )
+{
+  va_list ap;
+
+  if( c->errcode!=0 && c->errpos<=pos ) return;
+  c->errpos=pos; c->errcode=code;
+  va_start( ap, fmt );
+  vsnprintf( c->err, sizeof(c->err), fmt, ap );
+  va_end( ap );
+
+} /* PError */
+
+/* grows array *a of *max elements of size to hold index need; returns 0 if not enough memory */
+int PGrow( struct pchunk * c, void ** a, int *max, int need, size_t size )
+{
+  int newmax;
+  void * q;
+
+  if( need < *max ) return( 1 );
+  newmax=(*max>0)? *max: 1024;
+  while( newmax <= need ) newmax*=2;
+  q=realloc( *a, (size_t)newmax*size );
+  if( q==NULL ) { PError( c, -1, 3, "not enough memory (ParseParallel)" ); return( 0 ); }
+  *a=q; *max=newmax;
+  return( 1 );
+
+} /* PGrow */
+
+/* adds mention of name scanned at str+(*i) of kind, def for .ndr definitions; returns its number or -1 */
+int PRef( struct net * net, struct pchunk * c, char * str, int *i, int kind, int def )
+{
+  struct pref * r;
+  int i0=(*i);
+
+  if( ! PGrow( c, (void**)&c->ref, &c->maxref, c->nref, sizeof(struct pref) ) ) return( -1 );
+  r=c->ref+c->nref;
+  r->len=ScanName( str, i );
+  r->name=r->pos=str+i0-net->names; r->kind=kind; r->def=def; r->node=0;
+  return( c->nref++ );
+
+} /* PRef */
+
+int PArc( struct pchunk * c, int type, int r1, int r2, int w )
+{
+  if( ! PGrow( c, (void**)&c->arc, &c->maxarc, c->narc, sizeof(struct parc) ) ) return( 0 );
+  c->arc[c->narc].type=type; c->arc[c->narc].r1=r1; c->arc[c->narc].r2=r2; c->arc[c->narc++].w=w;
+  return( 1 );
+
+} /* PArc */
+
+int PSet( struct pchunk * c, int r, int x, int len )
+{
+  if( ! PGrow( c, (void**)&c->set, &c->maxset, c->nset, sizeof(struct pset) ) ) return( 0 );
+  c->set[c->nset].r=r; c->set[c->nset].x=x; c->set[c->nset++].len=len;
+  return( 1 );
+
+} /* PSet */
+
+int PCand( struct pchunk * c, struct pref * r, int mu )
+{
+  if( ! PGrow( c, (void**)&c->cand, &c->maxcand, c->ncand, sizeof(struct pcand) ) ) return( 0 );
+  c->cand[c->ncand].name=r->name; c->cand[c->ncand].len=r->len; c->cand[c->ncand].kind=r->kind;
+  c->cand[c->ncand].pos=r->pos; c->cand[c->ncand++].mu=mu;
+  return( 1 );
+
+} /* PCand */
+
+/* tokenizes lines of chunk c of .ndr as ReadNDR does */
+void TokenizeNDR( struct net * net, struct pchunk * c )
+{
+ int i, len, w, ii, r, r1, r2, lenn;
+ char *str, *s=c->s, *names=net->names;
+
+ while( s < c->end )
+ {
+   str=s;
+   s=NextLine( s, c->end, &len );
+   if( str[0]=='#' ) continue; /* comment line */
+
+   i=0;
+   SwallowSpace( str, &i );
+   if( i==len ) continue; /*empty line */
+
+   switch( str[i++] )
+   {
+     case 'p':
+	SwallowSpace( str, &i );
+	while( ! IsSpace( str,i) && i<len )i++; /* x */
+	SwallowSpace( str, &i );
+	while( ! IsSpace( str,i) && i<len )i++; /* y */
+	SwallowSpace( str, &i );
+	if( ( r=PRef( net, c, str, &i, 1, 1 ) )<0 ) return;
+	EndName( str, &i );
+	SwallowSpace( str, &i );
+	if( ! PCand( c, c->ref+r, atoi( str+i ) ) ) return;
+	break;
+
+     case 't':
+	SwallowSpace( str, &i );
+	while( ! IsSpace( str,i) && i<len )i++; /* xpos */
+	SwallowSpace( str, &i );
+	while( ! IsSpace( str,i) && i<len )i++; /* ypos */
+	SwallowSpace( str, &i );
+	if( ( r=PRef( net, c, str, &i, -1, 1 ) )<0 ) return;
+	EndName( str, &i );
+	if( ! PCand( c, c->ref+r, 0 ) ) return;
+	SwallowSpace( str, &i );
+	while( ! IsSpace( str,i) && i<len )i++; /* anchor */
+	SwallowSpace( str, &i );
+	while( ! IsSpace( str,i) && i<len )i++; /* eft */
+	SwallowSpace( str, &i );
+	while( ! IsSpace( str,i) && i<len )i++; /* lft */
+	SwallowSpace( str, &i );
+	while( ! IsSpace( str,i) && i<len )i++; /* anchor */
+	SwallowSpace( str, &i );
+	ii=str+i-names;
+	lenn=ScanName( str, &i );
+	if( lenn>=HSN_prefix_length+2 && memcmp( HSN_prefix, names+ii, HSN_prefix_length )==0 )
+	  if( ! PSet( c, r, ii, lenn ) ) return;
+	break;
+
+     case 'e':
+	SwallowSpace( str, &i );
+	if( ( r1=PRef( net, c, str, &i, 0, 0 ) )<0 ) return;
+	c->ref[r1].pos=str-names;
+	SwallowSpace( str, &i );
+	if( isdigit(str[i])) while( ! IsSpace( str,i) && i<len )i++; /* rad */
+	SwallowSpace( str, &i );
+	if( isdigit(str[i])) while( ! IsSpace( str,i) && i<len )i++; /* ang */
+	SwallowSpace( str, &i );
+	if( ( r2=PRef( net, c, str, &i, 0, 0 ) )<0 ) return;
+	c->ref[r2].pos=str-names;
+	/* start from end */
+	i=len-1;
+	while( IsSpace( str,i) && i>0 )i--;
+	while( ! IsSpace( str,i) && i>0 )i--; /* anchor */
+	while( IsSpace( str,i) && i>0 )i--;
+	while( ! IsSpace( str,i) && i>0 )i--; /* weight */
+	w=atoi( str+i+1 ); /* multiplicity */
+	if( ! PArc( c, PA_ANY, r1, r2, w ) ) return;
+	break;
+
+     case 'h':
+       SwallowSpace( str, &i );
+       c->netname = str+i-names;
+       ScanName( str, &i );
+       EndName( str, &i );
+       break;
+   } /* switch */
+ } /* while */
+
+} /* TokenizeNDR */
+
+/* tokenizes arcs "inputs -> outputs" of mention r of kind as GetArcs does; returns 0 on error */
+int PArcs( struct net * net, struct pchunk * c, char * str, int *i, int r, int kind )
+{
+  int side=0, x, w, e;
+  char * fmt;
+
+  while( 1 )
+  {
+    SwallowSpace( str, i );
+    if( str[(*i)]=='\0' ) break;
+    if( str[(*i)]=='-' && str[(*i)+1]=='>' ) { (*i)+=2; side=1; continue; }
+    if( ( x=PRef( net, c, str, i, -kind, 0 ) )<0 ) return( 0 );
+    e=(*i);
+    if( ( fmt=ArcWeight( str, i, ( kind<0 )==side, &w ) )!=NULL ) { PError( c, str+(*i)-net->names, 2, fmt, str ); return( 0 ); }
+    /* name is terminated after its weight suffix is read */
+    if( str[e]!='\0' ) { str[e]='\0'; if( (*i)==e ) (*i)++; }
+    if( kind<0 && side==0 ) { if( ! PArc( c, PA_APT, x, r, w ) ) return( 0 ); }
+    else if( kind<0 && side==1 ) { if( ! PArc( c, PA_ATP, x, r, w ) ) return( 0 ); }
+    else if( kind>0 && side==0 ) { if( ! PArc( c, PA_ATP, r, x, w ) ) return( 0 ); }
+    else if( ! PArc( c, PA_APT, r, x, w ) ) return( 0 );
+  }
+  return( 1 );
+
+} /* PArcs */
+
+/* tokenizes lines of chunk c of .net as ReadNET does; arcs p->t and t->p keep mentions of place and transition */
+void TokenizeNET( struct net * net, struct pchunk * c )
+{
+ int i, len, r, ii, npr, k, h, t;
+ char *kw, *str, *s=c->s, *names=net->names;
+
+ while( s < c->end )
+ {
+   str=s;
+   s=NextLine( s, c->end, &len );
+   i=0;
+   SwallowSpace( str, &i );
+   if( i==len || str[i]=='#' ) continue; /* empty or comment line */
+   kw=str+i;
+   while( ! IsSpace( str,i) ) i++;
+   SwallowSpace( str, &i );
+
+   if( memcmp( kw, "tr", 2 )==0 && IsSpace( kw, 2 ) )
+   {
+     if( ( r=PRef( net, c, str, &i, -1, 0 ) )<0 ) return;
+     EndName( str, &i );
+     SwallowSpace( str, &i );
+     if( str[i]==':' ) /* label */
+     {
+       i++;
+       SwallowSpace( str, &i );
+       ii=str+i-names;
+       k=ScanName( str, &i );
+       if( k>=HSN_prefix_length+2 && memcmp( HSN_prefix, names+ii, HSN_prefix_length )==0 )
+         if( ! PSet( c, r, ii, k ) ) return;
+       SwallowSpace( str, &i );
+     }
+     if( str[i]=='[' || str[i]==']' ) /* interval */
+     {
+       i++;
+       while( str[i]!='\0' && str[i]!='[' && str[i]!=']' ) i++;
+       if( str[i]!='\0' ) i++;
+     }
+     if( ! PArcs( net, c, str, &i, r, -1 ) ) return;
+   }
+   else if( memcmp( kw, "pl", 2 )==0 && IsSpace( kw, 2 ) )
+   {
+     if( ( r=PRef( net, c, str, &i, 1, 0 ) )<0 ) return;
+     EndName( str, &i );
+     SwallowSpace( str, &i );
+     if( str[i]==':' ) /* label */
+     {
+       i++;
+       SwallowSpace( str, &i );
+       ScanName( str, &i );
+       SwallowSpace( str, &i );
+     }
+     if( str[i]=='(' ) /* marking */
+     {
+       i++;
+       if( ! PSet( c, r, GetNum( str, &i ), -1 ) ) return;
+       if( str[i]==')' ) i++;
+     }
+     if( ! PArcs( net, c, str, &i, r, 1 ) ) return;
+   }
+   else if( memcmp( kw, "pr", 2 )==0 && IsSpace( kw, 2 ) )
+   {
+     npr=0; h=0; k=0; /* names before relation: pr[0..h-1], k=1 for '>', k=-1 for '<' */
+     while( 1 )
+     {
+       SwallowSpace( str, &i );
+       if( str[i]=='\0' ) break;
+       if( str[i]=='>' || str[i]=='<' ) { h=npr; k=(str[i]=='>')? 1: -1; i++; continue; }
+       if( ! PGrow( c, (void**)&c->pr, &c->maxpr, npr, sizeof(int) ) ) return;
+       if( ( c->pr[ npr++ ]=PRef( net, c, str, &i, -1, 0 ) )<0 ) return;
+       EndName( str, &i );
+     }
+     if( k==0 ) { PError( c, str+len-names, 2, "invalid priority: %s", kw ); return; }
+     for( t=0; t<h; t++ )
+       for( ii=h; ii<npr; ii++ )
+         if( ! ( ( k>0 )? PArc( c, PA_ATT, c->pr[t], c->pr[ii], 0 ): PArc( c, PA_ATT, c->pr[ii], c->pr[t], 0 ) ) ) return;
+   }
+   else if( memcmp( kw, "net", 3 )==0 && IsSpace( kw, 3 ) )
+   {
+     c->netname = str+i-names;
+     ScanName( str, &i );
+     EndName( str, &i );
+   }
+ } /* while */
+
+} /* TokenizeNET */
+
+/* candidates of .net chunk: first mentions of names in the chunk */
+void PFirstMentions( struct net * net, struct pchunk * c )
+{
+  int *loc, size, k, j;
+  unsigned h;
+  struct pref * r;
+
+  for( size=1024; size < 2*(c->nref+1); size*=2 );
+  loc=(int*) calloc( size, sizeof(int) );
+  if( loc==NULL ) { PError( c, -1, 3, "not enough memory (ParseParallel)" ); return; }
+  for( k=0; k<c->nref; k++ )
+  {
+    r=c->ref+k;
+    h=HashName( net->names+r->name, r->len ) & (size-1);
+    while( ( j=loc[h] )!=0 )
+    {
+      if( c->cand[j-1].len==r->len && memcmp( net->names+c->cand[j-1].name, net->names+r->name, r->len )==0 ) break;
+      h=(h+1) & (size-1);
+    }
+    if( j!=0 ) continue;
+    if( ! PCand( c, r, 0 ) ) break;
+    loc[h]=c->ncand;
+  }
+  free( loc );
+
+} /* PFirstMentions */
+
+/* candidate of the index having name of len characters, or -1 */
+int PFind( struct pparse * pp, char * name, int len )
+{
+  struct net * net=pp->net;
+  unsigned h;
+  int v;
+
+  h=HashName( name, len ) & (net->maxhidx-1);
+  while( ( v=net->hidx[h] )!=0 )
+  {
+    if( pp->gc[v-1].len==len && memcmp( net->names+pp->gc[v-1].name, name, len )==0 ) return( v-1 );
+    h=(h+1) & (net->maxhidx-1);
+  }
+  return( -1 );
+
+} /* PFind */
+
+/* adds candidate g to the index concurrently; the slot of a name keeps its earliest candidate */
+void PIndex( struct pparse * pp, int g )
+{
+  struct net * net=pp->net;
+  struct pcand * x=pp->gc+g, * o;
+  unsigned h;
+  int v;
+
+  h=HashName( net->names+x->name, x->len ) & (net->maxhidx-1);
+  while( 1 )
+  {
+    v=__atomic_load_n( net->hidx+h, __ATOMIC_ACQUIRE );
+    if( v==0 )
+    {
+      if( __atomic_compare_exchange_n( net->hidx+h, &v, g+1, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED ) ) return;
+      continue;
+    }
+    o=pp->gc+v-1;
+    if( o->len==x->len && memcmp( net->names+o->name, net->names+x->name, x->len )==0 )
+    {
+      if( o->pos < x->pos ) return;
+      if( __atomic_compare_exchange_n( net->hidx+h, &v, g+1, 0, __ATOMIC_RELEASE, __ATOMIC_RELAXED ) ) return;
+      continue;
+    }
+    h=(h+1) & (net->maxhidx-1);
+  }
+
+} /* PIndex */
+
+/* resolves mentions and arcs of chunk c: .ndr names are defined before use, .net names keep their kind */
+void PResolve( struct pparse * pp, struct pchunk * c )
+{
+  struct net * net=pp->net;
+  struct pref * r, * r1, * r2;
+  struct parc * a;
+  int k, g, n1, n2;
+
+  for( k=0; k<c->nref; k++ )
+  {
+    r=c->ref+k;
+    g=PFind( pp, net->names+r->name, r->len );
+    if( r->def ) /* .ndr definition */
+    {
+      if( pp->gc[g].pos!=r->pos ) PError( c, r->pos, 2, "duplicate name: %s", net->names+r->name );
+        else r->node=pp->gnode[g];
+    }
+    else if( r->kind==0 ) r->node=( g>=0 && pp->gc[g].pos<r->pos )? pp->gnode[g]: 0;
+    else if( pp->gc[g].kind!=r->kind )
+      PError( c, r->pos, 2, "name of both place and transition: %.*s", r->len, net->names+r->name );
+    else r->node=pp->gnode[g];
+  }
+  for( k=0; k<c->narc; k++ )
+  {
+    a=c->arc+k; r1=c->ref+a->r1; r2=c->ref+a->r2;
+    n1=r1->node; n2=r2->node;
+    if( a->type==PA_ANY )
+    {
+      if( n1>0 && n2<0 ) { a->type=PA_APT; a->r1=n1; a->r2=-n2; }
+      else if( n1<0 && n2>0 ) { a->type=PA_ATP; a->r1=n2; a->r2=-n1; }
+      else if( n1<0 && n2<0 ) { a->type=PA_ATT; a->r1=-n1; a->r2=-n2; }
+      else { PError( c, r1->pos, 2, "unknown arc: %.*s -> %.*s", r1->len, net->names+r1->name, r2->len, net->names+r2->name ); continue; }
+    }
+    else if( a->type==PA_ATT ) { a->r1=-n1; a->r2=-n2; }
+    else { a->r1=n1; a->r2=-n2; }
+    c->na[ a->type ]++;
+  }
+
+} /* PResolve */
+
+void ParseChunk( struct pparse * pp, int id )
+{
+  struct net * net=pp->net;
+  struct pchunk * c=pp->c+id;
+  struct parc * a;
+  int k, g, p, t, lo, hi, v;
+
+  switch( pp->phase )
+  {
+    case PP_TOKENS:
+      if( pp->format==NDR ) TokenizeNDR( net, c );
+      else { TokenizeNET( net, c ); if( c->errcode!=3 ) PFirstMentions( net, c ); }
+      break;
+    case PP_INDEX:
+      memcpy( pp->gc+c->coff, c->cand, c->ncand*sizeof(struct pcand) );
+      for( k=0; k<c->ncand; k++ ) PIndex( pp, c->coff+k );
+      break;
+    case PP_COUNT:
+      for( k=0, g=c->coff; k<c->ncand; k++, g++ )
+        if( PFind( pp, net->names+pp->gc[g].name, pp->gc[g].len )==g )
+        {
+          pp->gnode[g]=1;
+          if( pp->gc[g].kind>0 ) c->np++; else c->nt++;
+        }
+      break;
+    case PP_NUMBER:
+      p=c->poff; t=c->toff;
+      for( k=0, g=c->coff; k<c->ncand; k++, g++ )
+        if( pp->gnode[g] )
+        {
+          if( pp->gc[g].kind>0 ) { net->pn[ ++p ]=pp->gc[g].name; net->mu[ p ]=pp->gc[g].mu; pp->gnode[g]=p; }
+            else { net->tn[ ++t ]=pp->gc[g].name; pp->gnode[g]=-t; }
+        }
+      break;
+    case PP_RESOLVE:
+      PResolve( pp, c );
+      break;
+    case PP_ARCS:
+      for( k=0; k<c->narc; k++ )
+      {
+        a=c->arc+k;
+        switch( a->type )
+        {
+          case PA_APT: net->aptp[ c->aoff[0] ]=a->r1; net->aptw[ c->aoff[0] ]=a->w; net->aptt[ c->aoff[0]++ ]=a->r2; break;
+          case PA_ATP: net->atpt[ c->aoff[1] ]=a->r2; net->atpw[ c->aoff[1] ]=a->w; net->atpp[ c->aoff[1]++ ]=a->r1; break;
+          case PA_ATT: net->att1[ c->aoff[2] ]=a->r1; net->att2[ c->aoff[2]++ ]=a->r2; break;
+        }
+      }
+      /* index of candidates becomes index of nodes */
+      lo=(int)((long long)net->maxhidx*id/pp->nc); hi=(int)((long long)net->maxhidx*(id+1)/pp->nc);
+      for( k=lo; k<hi; k++ )
+        if( ( v=net->hidx[k] )!=0 ) net->hidx[k]=pp->gnode[v-1];
+      break;
+  }
+
+} /* ParseChunk */
+
+void * parse_worker( void * arg )
+{
+  struct pjob * j=(struct pjob *)arg;
+
+  ParseChunk( j->pp, j->id );
+  return( NULL );
+
+} /* parse_worker */
+
+/* runs phase on chunks by threads, a chunk whose thread is not created is done by the caller */
+void ParsePhase( struct pparse * pp, int phase )
+{
+  int k;
+  char * ok;
+
+  pp->phase=phase;
+  ok=(char*) calloc( pp->nc, 1 );
+  for( k=1; k<pp->nc; k++ )
+    if( ok!=NULL ) ok[k]=( pthread_create( pp->th+k, NULL, parse_worker, pp->job+k )==0 );
+  ParseChunk( pp, 0 );
+  for( k=1; k<pp->nc; k++ )
+    if( ok!=NULL && ok[k] ) pthread_join( pp->th[k], NULL ); else ParseChunk( pp, k );
+  free( ok );
+
+} /* ParsePhase */
+
+void FreeParse( struct net * net )
+{
+  struct pparse * pp=net->pp;
+  int k;
+
+  if( pp==NULL ) return;
+  if( pp->c!=NULL )
+    for( k=0; k<pp->nc; k++ )
+    {
+      free( pp->c[k].ref ); free( pp->c[k].cand ); free( pp->c[k].arc ); free( pp->c[k].set ); free( pp->c[k].pr );
+    }
+  free( pp->c ); free( pp->job ); free( pp->th ); free( pp->gc ); free( pp->gnode ); free( pp );
+  net->pp=NULL;
+
+} /* FreeParse */
+
+/* reports the earliest error of chunks, errors of memory only unless all */
+void ParseCheck( struct net * net, int all )
+{
+  struct pparse * pp=net->pp;
+  struct pchunk * e=NULL;
+  int k, code;
+  char err[ 2*FILENAMELEN ];
+
+  for( k=0; k<pp->nc; k++ )
+    if( pp->c[k].errcode==3 || ( all && pp->c[k].errcode!=0 ) )
+      if( e==NULL || pp->c[k].errpos < e->errpos ) e=pp->c+k;
+  if( e==NULL ) return;
+  code=e->errcode; strcpy( err, e->err );
+  FreeParse( net );
+  NetError( net, code, "%s", err );
+
+} /* ParseCheck */
+
+/* chunks of parallel parse of input of format, 1 for sequential parse */
+int ParseChunks( struct net * net, int format )
+{
+  size_t nc;
+
+  if( ( format!=NDR && format!=NET ) || net->opt.nthreads<2 ) return( 1 );
+  nc=net->nnames/PARSE_CHUNK;
+  if( nc>(size_t)net->opt.nthreads ) nc=net->opt.nthreads;
+  return( ( nc>1 )? (int)nc: 1 );
+
+} /* ParseChunks */
+
+void ParseParallel( struct net * net, int format, int nc )
+{
+  struct pparse * pp;
+  struct pchunk * c;
+  char * b, * end=net->names+net->nnames;
+  int k, j, eh, np=0, nt=0, na[3]={0,0,0};
+
+  net->m=0; net->n=0; net->l=0;
+  pp=net->pp=(struct pparse *) calloc( 1, sizeof(struct pparse) );
+  if( pp==NULL ) NetError( net, 3, "not enough memory (ParseParallel)" );
+  pp->net=net; pp->format=format; pp->nc=nc;
+  pp->c=(struct pchunk *) calloc( nc, sizeof(struct pchunk) );
+  pp->job=(struct pjob *) malloc( nc*sizeof(struct pjob) );
+  pp->th=(pthread_t *) malloc( nc*sizeof(pthread_t) );
+  if( pp->c==NULL || pp->job==NULL || pp->th==NULL ) { FreeParse( net ); NetError( net, 3, "not enough memory (ParseParallel)" ); }
+
+  /* chunks of whole lines */
+  for( k=0; k<nc; k++ )
+  {
+    c=pp->c+k;
+    pp->job[k].pp=pp; pp->job[k].id=k;
+    c->netname=-1;
+    if( k==0 ) c->s=net->names;
+    else
+    {
+      b=net->names+net->nnames/nc*k;
+      if( b<pp->c[k-1].s ) b=pp->c[k-1].s;
+      b=(char*) memchr( b, '\n', end-b );
+      c->s=( b==NULL )? end: b+1;
+    }
+    if( k>0 ) pp->c[k-1].end=c->s;
+  }
+  pp->c[nc-1].end=end;
+
+  ParsePhase( pp, PP_TOKENS );
+  ParseCheck( net, 0 );
+
+  /* index of candidates */
+  for( k=0; k<nc; k++ ) { pp->c[k].coff=pp->ncand; pp->ncand+=pp->c[k].ncand; }
+  pp->gc=(struct pcand *) malloc( (pp->ncand+1)*sizeof(struct pcand) );
+  pp->gnode=(int*) calloc( pp->ncand+1, sizeof(int) );
+  if( pp->gc==NULL || pp->gnode==NULL ) { FreeParse( net ); NetError( net, 3, "not enough memory (ParseParallel)" ); }
+  for( eh=hidxINIT; eh < 2*(pp->ncand+1); eh*=2 );
+  if( eh > net->maxhidx )
+  {
+    NetFree( net, net->hidx, net->maxhidx*sizeof(int) ); net->hidx=NULL; net->maxhidx=0;
+    net->hidx = (int*) NetRealloc( net, NULL, 0, eh*sizeof(int), "ParseParallel" ); net->maxhidx=eh;
+  }
+  memset( net->hidx, 0, net->maxhidx*sizeof(int) );
+  ParsePhase( pp, PP_INDEX );
+
+  /* first candidates of names are numbered in file order */
+  ParsePhase( pp, PP_COUNT );
+  for( k=0; k<nc; k++ ) { pp->c[k].poff=np; np+=pp->c[k].np; pp->c[k].toff=nt; nt+=pp->c[k].nt; }
+  NetGrow( net, np+2, &net->maxm, "ParseParallel", &net->pn, &net->mu, NULL );
+  NetGrow( net, nt+2, &net->maxn, "ParseParallel", &net->tn, NULL, NULL );
+  net->m=np; net->n=nt; net->fhidx=np+nt;
+  ParsePhase( pp, PP_NUMBER );
+
+  ParsePhase( pp, PP_RESOLVE );
+  ParseCheck( net, 1 );
+  for( k=0; k<nc; k++ )
+    for( j=0; j<3; j++ ) { pp->c[k].aoff[j]=na[j]; na[j]+=pp->c[k].na[j]; }
+  NetGrow( net, na[0], &net->maxapt, "ParseParallel", &net->aptp, &net->aptt, &net->aptw ); net->fapt=na[0];
+  NetGrow( net, na[1], &net->maxatp, "ParseParallel", &net->atpp, &net->atpt, &net->atpw ); net->fatp=na[1];
+  NetGrow( net, na[2], &net->maxatt, "ParseParallel", &net->att1, &net->att2, NULL ); net->fatt=na[2];
+  ParsePhase( pp, PP_ARCS );
+
+  /* markings and labels in file order */
+  for( k=0; k<nc; k++ )
+  {
+    c=pp->c+k;
+    for( j=0; j<c->nset; j++ )
+      if( c->set[j].len<0 ) net->mu[ c->ref[ c->set[j].r ].node ]=c->set[j].x;
+        else TransitionLabel( net, -c->ref[ c->set[j].r ].node, c->set[j].x, c->set[j].len );
+    if( c->netname>=0 ) net->netname=c->netname;
+  }
+  FreeParse( net );
+
+} /* ParseParallel */
+
+unsigned GetU32( unsigned char * b )
+{
+  return( (unsigned)b[0] | (unsigned)b[1]<<8 | (unsigned)b[2]<<16 | (unsigned)b[3]<<24 );
+
+} /* GetU32 */
+
+uint64_t GetU64( unsigned char * b )
+{
+  return( (uint64_t)GetU32( b ) | (uint64_t)GetU32( b+4 )<<32 );
+
+} /* GetU64 */
+
+/* checks that section of k records of size rs at offset off lies inside the input */
+unsigned char * BLSNSection( struct net * net, uint64_t off, unsigned k, unsigned rs )
+{
+  if( off > net->nnames || (uint64_t)k*rs > net->nnames-off )
+    NetError( net, 2, "bad binary LSN: section out of file" );
+  return( (unsigned char*)net->names+off );
+
+} /* BLSNSection */
+
+/* name offset in names: string table entry s, or the final '\0' of input when there are no names */
+int BLSNName( struct net * net, uint64_t str, unsigned nstr, unsigned s )
+{
+  if( s==0xffffffffu || nstr==0 ) return( net->nnames );
+  if( s>=nstr ) NetError( net, 2, "bad binary LSN: name offset %u", s );
+  return( str+s );
+
+} /* BLSNName */
+
+/* fills the net from binary LSN loaded into names */
+void ReadBLSN( struct net * net )
+{
+  unsigned char *h, *b, *x;
+  unsigned napt, natp, natt, nnmu, nst, nmap, nstr, flags, i, k, f;
+  uint64_t str;
+  int p, t, w;
+
+  h=(unsigned char*)net->names;
+  if( net->nnames<blsnHEADER || memcmp( h, blsnMAGIC, 4 )!=0 )
+    NetError( net, 2, "bad binary LSN: no header" );
+  if( GetU32( h+4 )!=blsnVERSION || GetU32( h+8 )<blsnHEADER )
+    NetError( net, 2, "bad binary LSN: version %u", GetU32( h+4 ) );
+  flags=GetU32( h+12 );
+  net->m=GetU32( h+16 ); net->n=GetU32( h+20 );
+  napt=GetU32( h+24 ); natp=GetU32( h+28 ); natt=GetU32( h+32 );
+  nnmu=GetU32( h+36 ); nst=GetU32( h+40 ); nmap=GetU32( h+44 );
+  nstr=( flags & blsnNAMES )? GetU32( h+48 ): 0;
+  if( net->m<0 || net->n<0 || napt>INT32_MAX || natp>INT32_MAX || natt>INT32_MAX || nst>INT32_MAX || nmap>INT32_MAX )
+    NetError( net, 2, "bad binary LSN: sizes" );
+  str=GetU64( h+112 );
+  BLSNSection( net, str, nstr, 1 );
+  if( nstr>0 && net->names[ str+nstr-1 ]!='\0' )
+    NetError( net, 2, "bad binary LSN: string table not terminated" );
+  net->netname=( nstr>0 && GetU32( h+52 )!=0xffffffffu )? BLSNName( net, str, nstr, GetU32( h+52 ) ): -1;
+
+  NetGrow( net, net->m+1, &net->maxm, "ReadBLSN", &net->pn, &net->mu, NULL );
+  NetGrow( net, net->n+1, &net->maxn, "ReadBLSN", &net->tn, NULL, NULL );
+  NetGrow( net, napt, &net->maxapt, "ReadBLSN", &net->aptp, &net->aptt, &net->aptw );
+  NetGrow( net, natp, &net->maxatp, "ReadBLSN", &net->atpp, &net->atpt, &net->atpw );
+  NetGrow( net, natt, &net->maxatt, "ReadBLSN", &net->att1, &net->att2, NULL );
+
+  x=( nstr>0 )? BLSNSection( net, GetU64( h+104 ), net->m+net->n, 4 ): NULL;
+  for( p=1; p<=net->m; p++ ) { net->pn[p]=BLSNName( net, str, nstr, x? GetU32( x+4*(p-1) ): 0xffffffffu ); net->mu[p]=0; }
+  for( t=1; t<=net->n; t++ ) net->tn[t]=BLSNName( net, str, nstr, x? GetU32( x+4*(net->m+t-1) ): 0xffffffffu );
+
+  b=BLSNSection( net, GetU64( h+56 ), napt, 12 );
+  for( i=0; i<napt; i++, b+=12 )
+  {
+    p=GetU32( b ); t=GetU32( b+4 ); w=GetU32( b+8 );
+    if( p<1 || p>net->m || t<1 || t>net->n ) NetError( net, 2, "bad binary LSN: arc p->t %d %d", p, t );
+    net->aptp[i]=p; net->aptt[i]=t; net->aptw[i]=( w<0 )? 0: w;
+  }
+  net->fapt=napt;
+  b=BLSNSection( net, GetU64( h+64 ), natp, 12 );
+  for( i=0; i<natp; i++, b+=12 )
+  {
+    p=GetU32( b ); t=GetU32( b+4 );
+    if( p<1 || p>net->m || t<1 || t>net->n ) NetError( net, 2, "bad binary LSN: arc t->p %d %d", t, p );
+    net->atpp[i]=p; net->atpt[i]=t; net->atpw[i]=GetU32( b+8 );
+  }
+  net->fatp=natp;
+  b=BLSNSection( net, GetU64( h+72 ), natt, 8 );
+  for( i=0; i<natt; i++, b+=8 )
+  {
+    net->att1[i]=GetU32( b ); net->att2[i]=GetU32( b+4 );
+    if( net->att1[i]<1 || net->att1[i]>net->n || net->att2[i]<1 || net->att2[i]>net->n ) NetError( net, 2, "bad binary LSN: arc t->t" );
+  }
+  net->fatt=natt;
+  b=BLSNSection( net, GetU64( h+80 ), nnmu, 8 );
+  for( i=0; i<nnmu; i++, b+=8 )
+  {
+    p=GetU32( b );
+    if( p<1 || p>net->m ) NetError( net, 2, "bad binary LSN: marking of %d", p );
+    net->mu[p]=GetU32( b+4 );
+  }
+
+  /* HSN substitutions and place mappings */
+  NetGrow( net, nst, &net->maxhst, "ReadBLSN", &net->hst, &net->hnmp, &net->hsubn );
+  NetGrow( net, nmap, &net->maxhmap, "ReadBLSN", &net->hmap1, &net->hmap2, NULL );
+  b=BLSNSection( net, GetU64( h+88 ), nst, 16 );
+  for( i=0, f=0; i<nst; i++, b+=16 )
+  {
+    net->hst[i]=GetU32( b ); net->hnmp[i]=GetU32( b+4 ); k=GetU32( b+8 );
+    if( k!=f || net->hnmp[i]<0 || (unsigned)net->hnmp[i]>nmap-f ) NetError( net, 2, "bad binary LSN: substitution %u", i );
+    f+=net->hnmp[i];
+    net->hsubn[i]=BLSNName( net, str, nstr, GetU32( b+12 ) );
+  }
+  net->nhst=nst;
+  b=BLSNSection( net, GetU64( h+96 ), nmap, 8 );
+  for( i=0; i<nmap; i++, b+=8 ) { net->hmap1[i]=GetU32( b ); net->hmap2[i]=GetU32( b+4 ); }
+  net->nhmap=nmap;
+
+} /* ReadBLSN */
+
+/* reads text LSN/HSN: header, arcs, marking, substitutions; names from comment tables "; k name" */
+void ReadLSN( struct net * net )
+{
+  char *s, *e, *end, *q;
+  int len, i, k, nv, v[5], part=0, left=0, table=0, nnmu=0, nst=0, nmp=0, p, t;
+
+  net->m=0; net->n=0; net->l=0;
+  s=net->names; end=net->names+net->nnames;
+  while( s < end )
+  {
+    net->str=s;
+    s=NextLine( s, end, &len );
+    i=0;
+    SwallowSpace( net->str, &i );
+    if( i==len ) continue;
+    if( net->str[i]==';' ) /* comment: maybe table of names */
+    {
+      if( strstr( net->str, "Table of places" )!=NULL ) table=1;
+      else if( strstr( net->str, "Table of transitions" )!=NULL ) table=2;
+      else if( table>0 )
+      {
+        i++; SwallowSpace( net->str, &i );
+        k=strtol( net->str+i, &e, 10 );
+        if( e==net->str+i || ( *e!=' ' && *e!='\0' ) ) continue;
+        if( *e==' ' ) e++;
+        if( table==1 && k>=1 && k<=net->m ) net->pn[k]=e-net->names;
+        if( table==2 && k>=1 && k<=net->n ) net->tn[k]=e-net->names;
+      }
+      continue;
+    }
+    for( nv=0, q=net->str+i; nv<5; nv++ )
+    {
+      v[nv]=strtol( q, &e, 10 );
+      if( e==q ) break;
+      q=e;
+    }
+    if( part==0 ) /* m n narcs nnmu nst */
+    {
+      if( nv<4 ) NetError( net, 2, "bad LSN header: %s", net->str );
+      if( v[0]<0 || v[1]<0 || v[2]<0 || v[3]<0 ) NetError( net, 2, "bad LSN header: %s", net->str );
+      net->m=v[0]; net->n=v[1]; left=v[2]; nnmu=v[3]; nst=( nv==5 )? v[4]: 0;
+      NetGrow( net, net->m+1, &net->maxm, "ReadLSN", &net->pn, &net->mu, NULL );
+      NetGrow( net, net->n+1, &net->maxn, "ReadLSN", &net->tn, NULL, NULL );
+      for( p=1; p<=net->m; p++ ) { net->pn[p]=net->nnames; net->mu[p]=0; }
+      for( t=1; t<=net->n; t++ ) net->tn[t]=net->nnames;
+      part=1;
+    }
+    else if( part==1 ) /* p t w, -p t w, -t1 -t2 0 */
+    {
+      if( nv<3 ) NetError( net, 2, "bad LSN arc: %s", net->str );
+      if( v[0]>0 && v[1]>0 && v[0]<=net->m && v[1]<=net->n )
+      {
+        ExpandApt( net ); net->aptp[net->fapt]=v[0]; net->aptt[net->fapt]=v[1]; net->aptw[net->fapt++]=( v[2]<0 )? 0: v[2];
+      }
+      else if( v[0]<0 && v[1]>0 && -v[0]<=net->m && v[1]<=net->n )
+      {
+        ExpandAtp( net ); net->atpp[net->fatp]=-v[0]; net->atpt[net->fatp]=v[1]; net->atpw[net->fatp++]=v[2];
+      }
+      else if( v[0]<0 && v[1]<0 && -v[0]<=net->n && -v[1]<=net->n )
+      {
+        ExpandAtt( net ); net->att1[net->fatt]=-v[0]; net->att2[net->fatt++]=-v[1];
+      }
+      else NetError( net, 2, "bad LSN arc: %s", net->str );
+      left--;
+    }
+    else if( part==2 ) /* p mu */
+    {
+      if( nv<2 || v[0]<1 || v[0]>net->m ) NetError( net, 2, "bad LSN marking: %s", net->str );
+      net->mu[ v[0] ]=v[1];
+      left--;
+    }
+    else if( part==3 ) /* t nmp subnet */
+    {
+      if( nv<2 || v[0]<1 || v[0]>net->n || v[1]<0 ) NetError( net, 2, "bad LSN substitution: %s", net->str );
+      q=net->str+i;
+      for( k=0; k<2; k++ ) { while( *q==' ' || *q=='\t' ) q++; while( *q!=' ' && *q!='\t' && *q!='\0' ) q++; }
+      while( *q==' ' || *q=='\t' ) q++;
+      e=q; while( *e!=' ' && *e!='\t' && *e!='\0' ) e++;
+      *e='\0';
+      NetGrow( net, net->nhst, &net->maxhst, "ReadLSN", &net->hst, &net->hnmp, &net->hsubn );
+      net->hst[net->nhst]=v[0]; net->hnmp[net->nhst]=v[1]; net->hsubn[net->nhst++]=q-net->names;
+      nmp=v[1];
+      if( nmp>0 ) part=4; else left--;
+    }
+    else if( part==4 ) /* hp lp */
+    {
+      if( nv<2 ) NetError( net, 2, "bad LSN place mapping: %s", net->str );
+      NetGrow( net, net->nhmap, &net->maxhmap, "ReadLSN", &net->hmap1, &net->hmap2, NULL );
+      net->hmap1[net->nhmap]=v[0]; net->hmap2[net->nhmap++]=v[1];
+      if( --nmp==0 ) { part=3; left--; }
+    }
+    /* next part when this one is read */
+    if( part==1 && left==0 ) { part=2; left=nnmu; }
+    if( part==2 && left==0 ) { part=3; left=nst; }
+    if( part==3 && left==0 ) part=5;
+  }
+  if( part>0 && part<5 ) NetError( net, 2, "bad LSN: unexpected end of file" );
+
+} /* ReadLSN */
+
+/* buffered output: own buffer, hand-made number formatting, bulk write;
+   output to memory (fd<0) grows the buffer instead; errors are kept in err and reported on close */
+struct obuf {
+  int fd;
+  char *buf;
+  size_t len, cap;
+  size_t total;  /* bytes written */
+  int err;       /* 2 write, 3 memory */
+};
+
+/* file FileName, "-" stdout, NULL memory; NULL if not opened */
+struct obuf * OutOpen( char * FileName )
+{
+  struct obuf * o;
+
+  o=(struct obuf *) malloc( sizeof(struct obuf) );
+  if( o==NULL ) return( NULL );
+  if( FileName==NULL ) o->fd=-1;
+    else if( strcmp( FileName, "-" )==0 ) o->fd=1;
+    else o->fd=open( FileName, O_WRONLY|O_CREAT|O_TRUNC, 0666 );
+  if( o->fd<0 && FileName!=NULL ) { free( o ); return( NULL ); }
+  o->cap=obufSIZE; o->len=0; o->total=0; o->err=0;
+  o->buf=(char*) malloc( o->cap );
+  if( o->buf==NULL ) { if( o->fd>1 ) close( o->fd ); free( o ); return( NULL ); }
+  return( o );
+
+} /* OutOpen */
+
+void OutWrite( struct obuf * o, const char * s, size_t len )
+{
+  size_t k=0;
+  ssize_t r;
+
+  while( k < len && ! o->err )
+  {
+    r=write( o->fd, s+k, len-k );
+    if( r<=0 ) o->err=2; else k+=r;
+  }
+  o->total+=len;
+
+} /* OutWrite */
+
+/* memory output: room for k more bytes, or the output is dropped */
+void OutGrow( struct obuf * o, size_t k )
+{
+  size_t cap;
+  char * b;
+
+  for( cap=o->cap; cap < o->len+k; cap*=2 );
+  b=( o->err )? NULL: (char*) realloc( o->buf, cap );
+  if( b==NULL ) { o->err=3; o->len=0; return; }
+  o->buf=b; o->cap=cap;
+
+} /* OutGrow */
+
+void OutFlush( struct obuf * o )
+{
+  if( o->fd<0 ) { OutGrow( o, o->cap ); return; }
+  OutWrite( o, o->buf, o->len );
+  o->len=0;
+
+} /* OutFlush */
+
+/* returns error of output: 0, 2 write, 3 memory */
+int OutClose( struct obuf * o )
+{
+  int err;
+
+  if( o->fd>=0 ) OutFlush( o );
+  if( o->fd>1 ) close( o->fd );
+  err=o->err;
+  free( o->buf ); free( o );
+  return( err );
+
+} /* OutClose */
+
+void OutMem( struct obuf * o, const char * s, size_t k )
+{
+  if( o->len+k > o->cap )
+  {
+    if( o->fd<0 ) { OutGrow( o, k ); if( o->err ) return; }
+    else
+    {
+      OutFlush( o );
+      if( k > o->cap ) { OutWrite( o, s, k ); return; } /* larger than buffer */
+    }
+  }
+  memcpy( o->buf+o->len, s, k );
+  o->len+=k;
+
+} /* OutMem */
+
+void OutStr( struct obuf * o, const char * s )
+{
+  OutMem( o, s, strlen(s) );
+
+} /* OutStr */
+
+void OutChar( struct obuf * o, char c )
+{
+  if( o->len >= o->cap ) OutFlush( o );
+  o->buf[ o->len++ ]=c;
+
+} /* OutChar */
+
+void OutInt( struct obuf * o, int x )
+{
+  char d[12];
+  int k=12;
+  unsigned u;
+
+  if( o->len+12 > o->cap ) OutFlush( o );
+  u=(x<0)? 0u-(unsigned)x: (unsigned)x;
+  do { d[ --k ]='0'+u%10; u/=10; } while( u!=0 );
+  if( x<0 ) d[ --k ]='-';
+  memcpy( o->buf+o->len, d+k, 12-k );
+  o->len+=12-k;
+
+} /* OutInt */
+
+void OutLong( struct obuf * o, long long x )
+{
+  char d[21];
+  int k=21;
+  unsigned long long u;
+
+  if( o->len+21 > o->cap ) OutFlush( o );
+  u=(x<0)? 0ull-(unsigned long long)x: (unsigned long long)x;
+  do { d[ --k ]='0'+u%10; u/=10; } while( u!=0 );
+  if( x<0 ) d[ --k ]='-';
+  memcpy( o->buf+o->len, d+k, 21-k );
+  o->len+=21-k;
+
+} /* OutLong */
+
+void OutHex( struct obuf * o, unsigned long long x )
+{
+  char d[16];
+  int k=16;
+
+  if( o->len+16 > o->cap ) OutFlush( o );
+  do { d[ --k ]="0123456789abcdef"[ x&15 ]; x>>=4; } while( x!=0 );
+  memcpy( o->buf+o->len, d+k, 16-k );
+  o->len+=16-k;
+
+} /* OutHex */
+
+/* line of numbers "a b c" */
+void OutInt3( struct obuf * o, int a, int b, int c )
+{
+  OutInt( o, a ); OutChar( o, ' ' );
+  OutInt( o, b ); OutChar( o, ' ' );
+  OutInt( o, c ); OutChar( o, '\n' );
+
+} /* OutInt3 */
+
+/* formatted output of %d, %s, %c, %llx and %% */
+void OutFmt( struct obuf * o, const char * fmt, ... )
+{
+  va_list ap;
+  const char * s;
+
+  va_start( ap, fmt );
+  while( *fmt )
+  {
+    for( s=fmt; *s && *s!='%'; s++ );
+    if( s>fmt ) OutMem( o, fmt, s-fmt );
+    if( *s=='\0' ) break;
+    s++;
+    switch( *s )
+    {
+      case 'd': OutInt( o, va_arg( ap, int ) ); break;
+      case 's': OutStr( o, va_arg( ap, char * ) ); break;
+      case 'c': OutChar( o, (char) va_arg( ap, int ) ); break;
+      case 'l': s+=2;
+        if( *s=='d' ) OutLong( o, va_arg( ap, long long ) ); /* %lld */
+          else OutHex( o, va_arg( ap, unsigned long long ) ); /* %llx */
+        break;
+      default: OutChar( o, *s );
+    }
+    fmt=s+1;
+  }
+  va_end( ap );
+
+} /* OutFmt */
+
+void WriteNMP( struct net * net, struct obuf * f )
+{
+  int p; 
+  
+  for( p=1; p<=net->m; p++ )
+  {
+    OutFmt( f, "; %d %s\n", p, net->names + net->pn[p]  );
+  }
+
+}/* WriteNMP */
+
+void WriteNMT( struct net * net, struct obuf * f )
+{
+  int t; 
+  
+  for( t=1; t<=net->n; t++ )
+  {
+    OutFmt( f, "; %d %s\n", t, net->names + net->tn[t] );
+  }
+
+}/* WriteNMT */
+
+/* parses substitution labels into hst, hnmp, hsubn and place mappings hmap1, hmap2 in one pass:
+   label is tokenized in place, subnet name stays in names, mappings are appended to net storage */
+void ProcessHSNlabels( struct net * net )
+{
+  int i,j,k,hp,lp,v1,v2,len;
+  char *lab, *subn, *cptype, *cphname;
+  
+  for(j=1;j<=net->l;j++)
+  {
+    lab=net->names+net->tl[ j ];
+    i=0;
+    SwallowSpace(lab,&i);
+    subn=lab+i;
+    ScanName(lab,&i); EndName(lab,&i);
+    NetGrow( net, net->nhst, &net->maxhst, "ProcessHSNlabels", &net->hst, &net->hnmp, &net->hsubn );
+    k=net->nhst++;
+    net->hst[k]=net->tltn[ j ]; net->hnmp[k]=0; net->hsubn[k]=subn-net->names;
+    while(lab[i]!='\0')
+    {
+      SwallowSpace(lab,&i);
+      if(lab[i]=='\0') break;
+      cptype=lab+i;
+      ScanName(lab,&i); EndName(lab,&i);
+      SwallowSpace(lab,&i);
+      cphname=lab+i;
+      len=ScanName(lab,&i); EndName(lab,&i);
+      SwallowSpace(lab,&i);
+      lp=atoi(lab+i);
+      ScanName(lab,&i); EndName(lab,&i);
+      hp=FindName( net, cphname, len );
+      if(hp<=0)
+      NetError( net, 3, "error: invalid HSN label place name %s", cphname );
+      switch( (cptype[1]=='\0')? cptype[0]: 0 )
+      {
+        case 'i': v1=hp; v2=lp; break;
+        case 'o': v1=hp; v2=-lp; break;
+        case 's': v1=-hp; v2=lp; break;
+        case 'f': v1=-hp; v2=-lp; break;
+        default:
+          NetError( net, 3, "error: invalid HSN label place type %s", cptype );
+      }
+      NetGrow( net, net->nhmap, &net->maxhmap, "ProcessHSNlabels", &net->hmap1, &net->hmap2, NULL );
+      net->hmap1[net->nhmap]=v1; net->hmap2[net->nhmap++]=v2;
+      net->hnmp[k]++;
+    }
+  }
+}/* ProcessHSNlabels */
+
+void WriteHSN( struct net * net, struct obuf * f )
+{
+  int j,k,i=0;
+
+  for(j=0;j<net->nhst;j++)
+  {
+    OutFmt( f, "; HSN substitution transition: t nmp subnet\n"); 
+    OutFmt(f,"%d %d %s\n",net->hst[j],net->hnmp[j],net->names+net->hsubn[j]); 
+    OutFmt( f, "; HSN place mapping: hp lp\n"); 
+    for(k=0;k<net->hnmp[j];k++,i++)
+      OutFmt(f,"%d %d\n",net->hmap1[i],net->hmap2[i]);
+  }
+}/* WriteHSN */
+
+void WriteDepends( struct net * net, struct obuf * f );
+
+void WriteLSN( struct net * net, struct obuf * f )
+{
+  int i, p, nnmu=0; 
+  
+  for( p=1; p<=net->m; p++ )
+    if(net->mu[p]>0) nnmu++;
+  
+  OutFmt( f, "; LSN obtained from NDR\n");
+  OutFmt( f, "; m n narcs nnmu, nst\n");
+  OutFmt( f, "%d %d %d %d %d\n", net->m, net->n, net->fapt+net->fatp+net->fatt, nnmu, net->nhst );
+  if( net->opt.deps ) WriteDepends( net, f );
+  
+  OutFmt( f, "; p->t: p t w\n");
+  for( i=0; i<net->fapt; i++ )
+    OutInt3( f, net->aptp[i], net->aptt[i], (net->aptw[i]>0)?net->aptw[i]:-1 );
+  
+  OutFmt( f, "; t->p: -p t w\n");  
+  for( i=0; i<net->fatp; i++ )
+    OutInt3( f, -net->atpp[i], net->atpt[i], net->atpw[i] );
+  
+  OutFmt( f, "; t->t: -t1 -t2 0\n");    
+  for( i=0; i<net->fatt; i++ )
+    OutInt3( f, -net->att1[i], -net->att2[i], 0 );
+    
+  OutFmt( f, "; mu(p):\n");
+  for( p=1; p<=net->m; p++ )
+    if(net->mu[p]>0) OutFmt( f, "%d %d\n", p, net->mu[p] );
+      
+  if(net->nhst>0) 
+  {
+     WriteHSN( net, f );
+  }
+  
+  OutFmt( f, "; Table of places\n; no name\n");
+  WriteNMP( net, f );
+  
+  OutFmt( f, "; Table of transitions\n; no name\n");
+  WriteNMT( net, f );
+  
+  OutFmt( f, "; end of LSN\n");
+
+}/* WriteLSN */
+
+/* order[] of arcs sorted by transition at[], then by place ap[], stable: two counting sorts */
+void SortArcs( struct net * net, int na, int *ap, int *at, int *order )
+{
+  int i, k, nk=( net->m > net->n )? net->m: net->n;
+  int *cnt, *tmp;
+
+  cnt=(int*) malloc( (nk+2)*sizeof(int) );
+  tmp=(int*) malloc( (na+1)*sizeof(int) );
+  if( cnt==NULL || tmp==NULL ) NetError( net, 3, "not enough memory (SortArcs)" );
+  memset( cnt, 0, (nk+2)*sizeof(int) );
+  for( i=0; i<na; i++ ) cnt[ ap[i]+1 ]++;
+  for( k=1; k<=nk+1; k++ ) cnt[k]+=cnt[k-1];
+  for( i=0; i<na; i++ ) tmp[ cnt[ ap[i] ]++ ]=i;
+  memset( cnt, 0, (nk+2)*sizeof(int) );
+  for( i=0; i<na; i++ ) cnt[ at[i]+1 ]++;
+  for( k=1; k<=nk+1; k++ ) cnt[k]+=cnt[k-1];
+  for( i=0; i<na; i++ ) order[ cnt[ at[ tmp[i] ] ]++ ]=tmp[i];
+  free( cnt ); free( tmp );
+
+} /* SortArcs */
+
+/* merges sorted arcs of equal ends as GroupArcs does: a regular arc keeps the last weight, with inh an inhibitor arc
+   of weight <=0 is kept once after it with weight -1 as in LSN; writes gp, gt, gw and row starts ptr[t] of transitions 1..n+1,
+   returns number of arcs */
+int MergeArcs( struct net * net, int na, int *ap, int *at, int *aw, int inh, int *order, int *gp, int *gt, int *gw, int *ptr )
+{
+  int i, j, k=0, t, w, reg, ih;
+
+  for( i=0, t=1; i<na; i=j )
+  {
+    for( w=0, reg=0, ih=0, j=i; j<na && ap[ order[j] ]==ap[ order[i] ] && at[ order[j] ]==at[ order[i] ]; j++ )
+      if( inh && aw[ order[j] ]<=0 ) ih=1; else { reg=1; w=( aw==NULL )? 0: aw[ order[j] ]; }
+    for( ; t<=at[ order[i] ]; t++ ) ptr[t]=k;
+    if( reg ) { gp[k]=ap[ order[i] ]; gt[k]=at[ order[i] ]; gw[k++]=w; }
+    if( ih ) { gp[k]=ap[ order[i] ]; gt[k]=at[ order[i] ]; gw[k++]=-1; }
+  }
+  for( ; t<=net->n+1; t++ ) ptr[t]=k;
+  return( k );
+
+} /* MergeArcs */
+
+/* LSN with arcs grouped by transition and sorted by place; repeated arcs are merged as GroupArcs does;
+   with offsets, lines ";@ t b d r" give the first arc of transition t in the sections p->t, t->p, t->t;
+   with deps, lines ";&" follow them */
+void WriteLSN_grouped( struct net * net, struct obuf * f )
+{
+  int *order, *gp[3], *gt[3], *gw[3], *ptr[3], na[3], i, k, p, t, nnmu=0, nmax;
+
+  nmax=net->fapt;
+  if( net->fatp>nmax ) nmax=net->fatp;
+  if( net->fatt>nmax ) nmax=net->fatt;
+  order=(int*) malloc( (nmax+1)*sizeof(int) );
+  if( order==NULL ) NetError( net, 3, "not enough memory (WriteLSN_grouped)" );
+  for( k=0; k<3; k++ )
+  {
+    gp[k]=(int*) malloc( (nmax+1)*sizeof(int) ); gt[k]=(int*) malloc( (nmax+1)*sizeof(int) );
+    gw[k]=(int*) malloc( (nmax+1)*sizeof(int) ); ptr[k]=(int*) malloc( (net->n+2)*sizeof(int) );
+    if( gp[k]==NULL || gt[k]==NULL || gw[k]==NULL || ptr[k]==NULL ) NetError( net, 3, "not enough memory (WriteLSN_grouped)" );
+  }
+  SortArcs( net, net->fapt, net->aptp, net->aptt, order );
+  na[0]=MergeArcs( net, net->fapt, net->aptp, net->aptt, net->aptw, 1, order, gp[0], gt[0], gw[0], ptr[0] );
+  SortArcs( net, net->fatp, net->atpp, net->atpt, order );
+  na[1]=MergeArcs( net, net->fatp, net->atpp, net->atpt, net->atpw, 0, order, gp[1], gt[1], gw[1], ptr[1] );
+  SortArcs( net, net->fatt, net->att2, net->att1, order );
+  na[2]=MergeArcs( net, net->fatt, net->att2, net->att1, NULL, 0, order, gp[2], gt[2], gw[2], ptr[2] );
+
+  for( p=1; p<=net->m; p++ )
+    if(net->mu[p]>0) nnmu++;
+
+  OutFmt( f, "; LSN obtained from NDR, arcs grouped by transition\n");
+  OutFmt( f, "; m n narcs nnmu, nst\n");
+  OutFmt( f, "%d %d %d %d %d\n", net->m, net->n, na[0]+na[1]+na[2], nnmu, net->nhst );
+  if( net->opt.offsets )
+  {
+    OutFmt( f, "; offsets of arcs of transitions t=1..n+1 in sections: t p->t t->p t->t\n");
+    for( t=1; t<=net->n+1; t++ )
+      OutFmt( f, ";@ %d %d %d %d\n", t, ptr[0][t], ptr[1][t], ptr[2][t] );
+  }
+  if( net->opt.deps ) WriteDepends( net, f );
+
+  OutFmt( f, "; p->t: p t w\n");
+  for( i=0; i<na[0]; i++ )
+    OutInt3( f, gp[0][i], gt[0][i], gw[0][i] );
+
+  OutFmt( f, "; t->p: -p t w\n");
+  for( i=0; i<na[1]; i++ )
+    OutInt3( f, -gp[1][i], gt[1][i], gw[1][i] );
+
+  OutFmt( f, "; t->t: -t1 -t2 0\n");
+  for( i=0; i<na[2]; i++ )
+    OutInt3( f, -gt[2][i], -gp[2][i], 0 );
+
+  OutFmt( f, "; mu(p):\n");
+  for( p=1; p<=net->m; p++ )
+    if(net->mu[p]>0) OutFmt( f, "%d %d\n", p, net->mu[p] );
+
+  if(net->nhst>0)
+  {
+     WriteHSN( net, f );
+  }
+
+  OutFmt( f, "; Table of places\n; no name\n");
+  WriteNMP( net, f );
+
+  OutFmt( f, "; Table of transitions\n; no name\n");
+  WriteNMT( net, f );
+
+  OutFmt( f, "; end of LSN\n");
+
+  free( order );
+  for( k=0; k<3; k++ ) { free( gp[k] ); free( gt[k] ); free( gw[k] ); free( ptr[k] ); }
+
+}/* WriteLSN_grouped */
+
+void OutU32( struct obuf * f, unsigned x )
+{
+  char b[4];
+
+  b[0]=x; b[1]=x>>8; b[2]=x>>16; b[3]=x>>24;
+  OutMem( f, b, 4 );
+
+} /* OutU32 */
+
+void OutU64( struct obuf * f, uint64_t x )
+{
+  OutU32( f, (unsigned)x ); OutU32( f, (unsigned)(x>>32) );
+
+} /* OutU64 */
+
+/* pads output with zeros to offset off */
+void OutPad( struct obuf * f, uint64_t off )
+{
+  while( f->total+f->len < off ) OutChar( f, '\0' );
+
+} /* OutPad */
+
+#define ALIGN8(x) (((x)+7)&~(uint64_t)7)
+
+/* binary LSN: header, then sections apt {p t w}, atp {p t w}, att {t1 t2}, mu {p mu},
+   sub {t nmp first_map subnet}, map {hp lp}, nameidx of places and transitions, string table;
+   inhibitor arc has w=-1, names are offsets in string table */
+void WriteBLSN( struct net * net, struct obuf * f )
+{
+  int i, p, t, nnmu=0;
+  unsigned nstr=0, ss=0xffffffffu, sn;
+  uint64_t off[9];
+  char hdr[blsnHEADER];
+
+  for( p=1; p<=net->m; p++ )
+    if(net->mu[p]>0) nnmu++;
+  if( net->opt.bnames )
+  {
+    for( p=1; p<=net->m; p++ ) nstr+=strlen( net->names+net->pn[p] )+1;
+    for( t=1; t<=net->n; t++ ) nstr+=strlen( net->names+net->tn[t] )+1;
+    for( i=0; i<net->nhst; i++ ) nstr+=strlen( net->names+net->hsubn[i] )+1;
+    if( net->netname>=0 ) { ss=nstr; nstr+=strlen( net->names+net->netname )+1; }
+  }
+
+  off[0]=blsnHEADER;
+  off[1]=ALIGN8( off[0]+12*(uint64_t)net->fapt );
+  off[2]=ALIGN8( off[1]+12*(uint64_t)net->fatp );
+  off[3]=ALIGN8( off[2]+8*(uint64_t)net->fatt );
+  off[4]=ALIGN8( off[3]+8*(uint64_t)nnmu );
+  off[5]=ALIGN8( off[4]+16*(uint64_t)net->nhst );
+  off[6]=ALIGN8( off[5]+8*(uint64_t)net->nhmap );
+  off[7]=ALIGN8( off[6]+( net->opt.bnames? 4*(uint64_t)(net->m+net->n): 0 ) );
+  off[8]=off[7]+nstr;
+
+  memset( hdr, 0, blsnHEADER );
+  memcpy( hdr, blsnMAGIC, 4 );
+  OutMem( f, hdr, 4 );
+  OutU32( f, blsnVERSION ); OutU32( f, blsnHEADER ); OutU32( f, net->opt.bnames? blsnNAMES: 0 );
+  OutU32( f, net->m ); OutU32( f, net->n ); OutU32( f, net->fapt ); OutU32( f, net->fatp ); OutU32( f, net->fatt );
+  OutU32( f, nnmu ); OutU32( f, net->nhst ); OutU32( f, net->nhmap ); OutU32( f, nstr ); OutU32( f, ss );
+  for( i=0; i<9; i++ ) OutU64( f, off[i] ); /* off[8] is file size */
+
+  for( i=0; i<net->fapt; i++ )
+    { OutU32( f, net->aptp[i] ); OutU32( f, net->aptt[i] ); OutU32( f, (net->aptw[i]>0)?net->aptw[i]:-1 ); }
+  OutPad( f, off[1] );
+  for( i=0; i<net->fatp; i++ )
+    { OutU32( f, net->atpp[i] ); OutU32( f, net->atpt[i] ); OutU32( f, net->atpw[i] ); }
+  OutPad( f, off[2] );
+  for( i=0; i<net->fatt; i++ )
+    { OutU32( f, net->att1[i] ); OutU32( f, net->att2[i] ); }
+  OutPad( f, off[3] );
+  for( p=1; p<=net->m; p++ )
+    if(net->mu[p]>0) { OutU32( f, p ); OutU32( f, net->mu[p] ); }
+  OutPad( f, off[4] );
+
+  sn=0;
+  if( net->opt.bnames )
+  {
+    for( p=1; p<=net->m; p++ ) sn+=strlen( net->names+net->pn[p] )+1;
+    for( t=1; t<=net->n; t++ ) sn+=strlen( net->names+net->tn[t] )+1;
+  }
+  for( i=0, t=0; i<net->nhst; i++ )
+  {
+    OutU32( f, net->hst[i] ); OutU32( f, net->hnmp[i] ); OutU32( f, t );
+    if( net->opt.bnames ) { OutU32( f, sn ); sn+=strlen( net->names+net->hsubn[i] )+1; } else OutU32( f, 0xffffffffu );
+    t+=net->hnmp[i];
+  }
+  OutPad( f, off[5] );
+  for( i=0; i<net->nhmap; i++ )
+    { OutU32( f, net->hmap1[i] ); OutU32( f, net->hmap2[i] ); }
+  OutPad( f, off[6] );
+
+  if( net->opt.bnames )
+  {
+    sn=0;
+    for( p=1; p<=net->m; p++ ) { OutU32( f, sn ); sn+=strlen( net->names+net->pn[p] )+1; }
+    for( t=1; t<=net->n; t++ ) { OutU32( f, sn ); sn+=strlen( net->names+net->tn[t] )+1; }
+    OutPad( f, off[7] );
+    for( p=1; p<=net->m; p++ ) OutMem( f, net->names+net->pn[p], strlen( net->names+net->pn[p] )+1 );
+    for( t=1; t<=net->n; t++ ) OutMem( f, net->names+net->tn[t], strlen( net->names+net->tn[t] )+1 );
+    for( i=0; i<net->nhst; i++ ) OutMem( f, net->names+net->hsubn[i], strlen( net->names+net->hsubn[i] )+1 );
+    if( net->netname>=0 ) OutMem( f, net->names+net->netname, strlen( net->names+net->netname )+1 );
+  }
+
+}/* WriteBLSN */
+
+void WriteNMP_matr_h( struct net * net, struct obuf * f )
+{
+  int p; 
+  
+  for( p=1; p<=net->m; p++ )
+  {
+    OutFmt( f, "// %d\t%s\n", p-1, net->names + net->pn[p]  );
+  }
+
+}/* WriteNMP_matr_h */
+
+void WriteNMT_matr_h( struct net * net, struct obuf * f )
+{
+  int t; 
+  
+  for( t=1; t<=net->n; t++ )
+  {
+    OutFmt( f, "// %d\t%s\n", t-1, net->names + net->tn[t] );
+  }
+
+}/* WriteNMT_mart_h */
+
+#define MATRIX_SIZE(d1,d2,t) ((d1)*(d2)*(sizeof(t)))
+#define MOFF(i,j,d1,d2) ((d2)*(i)+(j))
+#define MELT(x,i,j,d1,d2) (*((x)+MOFF(i,j,d1,d2)))
+
+/* tables of C headers: with narrow, the narrowest fixed-width type holding the values lo..hi, otherwise int;
+   with progmem, constant tables are placed in flash and read by macros SN_PGM1/2/4 */
+struct ctab {
+  char * name;
+  char type[24];
+  int size;            /* bytes of element, 0 - int or SN_MU_T */
+  int flash, aligned;
+  long long count, lo, hi;
+};
+
+#define CTAB_MAX 16
+
+struct ctabs {
+  struct ctab t[CTAB_MAX];
+  int k;
+};
+
+/* narrowest fixed-width type of values lo..hi; returns its bytes */
+int CTypeName( long long lo, long long hi, char * type )
+{
+  int size;
+
+  if( lo>=0 ) size=( hi<=UINT8_MAX )? 1: ( hi<=UINT16_MAX )? 2: 4;
+    else size=( lo>=INT8_MIN && hi<=INT8_MAX )? 1: ( lo>=INT16_MIN && hi<=INT16_MAX )? 2: 4;
+  sprintf( type, "%sint%d_t", ( lo>=0 )? "u": "", 8*size );
+  return( size );
+
+} /* CTypeName */
+
+struct ctab * CTab( struct net * net, struct ctabs * ts, char * name, long long lo, long long hi, long long count, int isconst )
+{
+  struct ctab * c=ts->t+ts->k++;
+
+  c->name=name; c->count=count; c->lo=lo; c->hi=hi;
+  c->flash=( isconst && net->opt.progmem ); c->aligned=0;
+  if( net->opt.narrow ) c->size=CTypeName( lo, hi, c->type );
+    else { strcpy( c->type, "int" ); c->size=0; }
+  return( c );
+
+} /* CTab */
+
+/* range of values x[0..k-1] */
+void CRange( int *x, long long k, long long *lo, long long *hi )
+{
+  long long i;
+
+  *lo=*hi=0;
+  for( i=0; i<k; i++ )
+  {
+    if( x[i]<*lo ) *lo=x[i];
+    if( x[i]>*hi ) *hi=x[i];
+  }
+
+} /* CRange */
+
+/* declaration of table c up to '=' */
+void CTabDecl( struct obuf * f, struct ctab * c, char * dims )
+{
+  OutFmt( f, "static %s%s %s%s%s%s=", ( c->flash )? "const ": "", c->type, c->name, dims,
+          ( c->aligned )? " SN_ALIGNED": "", ( c->flash )? " PROGMEM": "" );
+
+} /* CTabDecl */
+
+/* element expr of table c */
+void CTabRead( struct obuf * f, struct ctab * c, char * expr )
+{
+  if( c->flash ) OutFmt( f, "((%s)SN_PGM%d(&%s))", c->type, c->size, expr );
+    else OutStr( f, expr );
+
+} /* CTabRead */
+
+/* macro mac for element expr of table c */
+void CTabMacro( struct obuf * f, struct ctab * c, char * mac, char * expr )
+{
+  OutFmt( f, "#define %s ", mac );
+  if( c->flash ) CTabRead( f, c, expr ); else OutFmt( f, "(%s)", expr );
+  OutStr( f, "\n" );
+
+} /* CTabMacro */
+
+/* macro mac(k,v) iterating k over row v of table of row pointers c */
+void CTabFor( struct obuf * f, struct ctab * c, char * mac, char * v )
+{
+  char a[64], b[64];
+
+  sprintf( a, "%s[%s]", c->name, v ); sprintf( b, "%s[(%s)+1]", c->name, v );
+  OutFmt( f, "#define %s(k,%s) for((k)=", mac, v ); CTabRead( f, c, a );
+  OutStr( f, ";(k)<" ); CTabRead( f, c, b ); OutStr( f, ";(k)++)\n" );
+
+} /* CTabFor */
+
+/* types of tables: fixed-width types, type of marking SN_MU_T and reading of flash */
+void CTabHead( struct net * net, struct obuf * f )
+{
+  if( ! net->opt.narrow ) return;
+  OutFmt( f, "#include <stdint.h>\n");
+  OutFmt( f, "// type of marking, define it for the values reached by the run\n");
+  OutFmt( f, "#ifndef SN_MU_T\n#define SN_MU_T int\n#endif\n");
+  if( ! net->opt.progmem ) return;
+  OutFmt( f, "// constant tables in flash\n");
+  OutFmt( f, "#if defined(__AVR__)\n#include <avr/pgmspace.h>\n");
+  OutFmt( f, "#define SN_PGM1(a) pgm_read_byte(a)\n#define SN_PGM2(a) pgm_read_word(a)\n#define SN_PGM4(a) pgm_read_dword(a)\n");
+  OutFmt( f, "#else\n#ifndef PROGMEM\n#define PROGMEM\n#endif\n");
+  OutFmt( f, "#define SN_PGM1(a) (*(a))\n#define SN_PGM2(a) (*(a))\n#define SN_PGM4(a) (*(a))\n#endif\n");
+
+} /* CTabHead */
+
+/* marking of m places as RAM table of SN_MU_T with narrow */
+struct ctab * CTabMu( struct net * net, struct ctabs * ts )
+{
+  long long lo, hi;
+  struct ctab * c;
+
+  CRange( net->mu+1, net->m, &lo, &hi );
+  c=CTab( net, ts, "mu", lo, hi, net->m, 0 );
+  if( net->opt.narrow ) { strcpy( c->type, "SN_MU_T" ); c->size=0; }
+  return( c );
+
+} /* CTabMu */
+
+/* size report of tables with narrow */
+void CTabReport( struct net * net, struct obuf * f, struct ctabs * ts )
+{
+  struct ctab * c;
+  long long flash=0, ram=0, nmu=0;
+  char type[24];
+  int i;
+
+  if( ! net->opt.narrow ) return;
+  OutFmt( f, "// Size of tables\n// table\ttype\telements\tbytes\tmemory\n");
+  for( i=0; i<ts->k; i++ )
+  {
+    c=ts->t+i;
+    if( c->size==0 )
+    {
+      CTypeName( c->lo, c->hi, type );
+      OutFmt( f, "// %s\t%s\t%lld\t%lld*sizeof(%s)\tRAM, initial values %lld..%lld fit %s\n",
+              c->name, c->type, c->count, c->count, c->type, c->lo, c->hi, type );
+      nmu+=c->count;
+      continue;
+    }
+    OutFmt( f, "// %s\t%s\t%lld\t%lld\t%s\n", c->name, c->type, c->count, c->count*c->size, ( c->flash )? "flash": "RAM" );
+    if( c->flash ) flash+=c->count*c->size; else ram+=c->count*c->size;
+  }
+  OutFmt( f, "// total: flash %lld bytes, RAM %lld bytes and %lld elements of SN_MU_T\n", flash, ram, nmu );
+
+} /* CTabReport */
+
+void prnMartC(struct obuf * f,int *x,int m,int n)
+{
+  int i,j;
+  OutFmt( f, "%s","{\n");
+  for(i=0;i<m;i++)
+  {
+  	OutFmt( f, "%c",'{');
+  	for(j=0;j<n;j++)
+  	{
+  		OutInt( f, MELT(x,i,j,m,n) );
+  		OutChar( f, (j<n-1)?',':'}' );
+	}
+	OutFmt( f, "%s",(i<m-1)?",\n":"\n");
+  }
+   OutFmt( f, "%s","};\n");
+}
+
+// Generate a matrix of priority arc chains. @ 2023 Qing Zhang: zhangq9919@163.com, Dmitry Zaitsev
+// Transitive closure of n x n bit matrix R with rows of nw 64-bit words: Warshall algorithm
+// blocked by 64 columns: rows of a block are closed first, then OR-ed into other rows by nthreads threads;
+// other rows take the block rows already closed, which still gives exactly the transitive closure
+
+#define BITROW(R,i,nw) ((R)+(size_t)(i)*(nw))
+#define GETBIT(R,i,j,nw) ((BITROW(R,i,nw)[(j)>>6]>>((j)&63))&1)
+#define SETBIT(R,i,j,nw) (BITROW(R,i,nw)[(j)>>6]|=((uint64_t)1)<<((j)&63))
+
+/* threads started before their number is known wait at the gate until the creator opens it */
+struct gate {
+  pthread_mutex_t mx;
+  pthread_cond_t cv;
+  int open;
+};
+
+void GateInit( struct gate * g )
+{
+  pthread_mutex_init( &g->mx, NULL );
+  pthread_cond_init( &g->cv, NULL );
+  g->open=0;
+
+} /* GateInit */
+
+void GateWait( struct gate * g )
+{
+  pthread_mutex_lock( &g->mx );
+  while( ! g->open ) pthread_cond_wait( &g->cv, &g->mx );
+  pthread_mutex_unlock( &g->mx );
+
+} /* GateWait */
+
+void GateOpen( struct gate * g )
+{
+  pthread_mutex_lock( &g->mx );
+  g->open=1;
+  pthread_cond_broadcast( &g->cv );
+  pthread_mutex_unlock( &g->mx );
+
+} /* GateOpen */
+
+void GateDestroy( struct gate * g )
+{
+  pthread_mutex_destroy( &g->mx );
+  pthread_cond_destroy( &g->cv );
+
+} /* GateDestroy */
+
+struct closure_job {
+  uint64_t *R;
+  int n, nw, id, nth;
+  pthread_barrier_t *bar;
+  struct gate *go;
+};
+
+void closure_rows( uint64_t *R, int nw, int kb, int kend, int lo, int hi )
+{
+  int i, k, w;
+  uint64_t *ri, *rk;
+
+  for( i=lo; i<hi; i++ )
+  {
+    ri=BITROW(R,i,nw);
+    if( ri[ kb>>6 ]==0 ) continue;
+    for( k=kb; k<kend; k++ )
+      if( k!=i && GETBIT(R,i,k,nw) )
+      {
+        rk=BITROW(R,k,nw);
+        for( w=0; w<nw; w++ ) ri[w]|=rk[w];
+      }
+  }
+}
+
+/* rows of the block itself: Warshall order, k outer */
+void closure_block( uint64_t *R, int nw, int kb, int kend )
+{
+  int i, k, w;
+  uint64_t *ri, *rk;
+
+  for( k=kb; k<kend; k++ )
+  {
+    rk=BITROW(R,k,nw);
+    for( i=kb; i<kend; i++ )
+      if( i!=k && GETBIT(R,i,k,nw) )
+      {
+        ri=BITROW(R,i,nw);
+        for( w=0; w<nw; w++ ) ri[w]|=rk[w];
+      }
+  }
+}
+
+void * closure_worker( void * arg )
+{
+  struct closure_job *j=(struct closure_job *)arg;
+  int kb, kend, lo, hi;
+
+  if( j->go!=NULL ) GateWait( j->go );
+  lo=(int)( (long long)j->n * j->id / j->nth );
+  hi=(int)( (long long)j->n * (j->id+1) / j->nth );
+  for( kb=0; kb<j->n; kb+=64 )
+  {
+    kend=(kb+64<j->n)? kb+64: j->n;
+    if( j->id==0 ) closure_block( j->R, j->nw, kb, kend );
+    if( j->nth>1 ) pthread_barrier_wait( j->bar );
+    if( lo<kb ) closure_rows( j->R, j->nw, kb, kend, lo, (hi<kb)? hi: kb );
+    if( hi>kend ) closure_rows( j->R, j->nw, kb, kend, (lo>kend)? lo: kend, hi );
+    if( j->nth>1 ) pthread_barrier_wait( j->bar );
+  }
+  return( NULL );
+}
+
+void priority_chain(struct net *net,uint64_t *R,int n,int nw)
+{
+  struct closure_job *jobs;
+  pthread_t *th;
+  pthread_barrier_t bar;
+  struct gate go;
+  int i, k, nth=net->opt.nthreads;
+
+  if( nth<=1 )
+  {
+    struct closure_job j1={ R, n, nw, 0, 1, NULL, NULL };
+    closure_worker( &j1 );
+    return;
+  }
+  jobs=(struct closure_job *) malloc( nth * sizeof(struct closure_job) );
+  th=(pthread_t *) malloc( nth * sizeof(pthread_t) );
+  if( jobs==NULL || th==NULL ) { free( jobs ); free( th ); NetError( net, 3, "not enough memory (priority_chain)" ); }
+  /* rows are split among the threads started, the caller is thread 0 */
+  GateInit( &go );
+  for( k=0; k<nth; k++ )
+  {
+    jobs[k].R=R; jobs[k].n=n; jobs[k].nw=nw; jobs[k].id=k; jobs[k].bar=&bar; jobs[k].go=&go;
+    if( k>0 && pthread_create( th+k, NULL, closure_worker, jobs+k )!=0 ) break;
+  }
+  for( i=0; i<k; i++ ) jobs[i].nth=k;
+  pthread_barrier_init( &bar, NULL, k );
+  GateOpen( &go );
+  closure_worker( jobs );
+  for( i=1; i<k; i++ ) pthread_join( th[i], NULL );
+  pthread_barrier_destroy( &bar );
+  GateDestroy( &go );
+  free( jobs ); free( th );
+}
+// END: Generate a matrix of priority arc chains. @ 2023 Qing Zhang: zhangq9919@163.com, Dmitry Zaitsev
+
+/* bit matrix of priority arcs closure, rows of *pnw words */
+uint64_t * PriorityBits( struct net * net, int *pnw )
+{
+  int i, nw;
+  uint64_t *R;
+  double t0=WallTime(), c0=( net->opt.stats )? CpuTime(): 0;
+
+  nw=(net->n+63)/64;
+  R=(uint64_t*) calloc( (size_t)net->n*nw+1, sizeof(uint64_t) );
+  if( R==NULL ) NetError( net, 3, "not enough memory (PriorityBits)" );
+  for( i=0; i<net->fatt; i++ )
+    SETBIT( R, net->att1[i]-1, net->att2[i]-1, nw );
+  priority_chain( net, R, net->n, nw );
+  *pnw=nw;
+  PhaseEnd( net, PH_CLOSURE, &t0, &c0 );
+  return( R );
+
+} /* PriorityBits */
+
+void prnBitMartC( struct obuf * f, uint64_t *R, int n, int nw )
+{
+  int i,j;
+  OutFmt( f, "%s","{\n");
+  for(i=0;i<n;i++)
+  {
+  	OutFmt( f, "%c",'{');
+  	for(j=0;j<n;j++)
+  	{
+  		OutChar( f, '0'+(int)GETBIT(R,i,j,nw) );
+  		OutChar( f, (j<n-1)?',':'}' );
+	}
+	OutFmt( f, "%s",(i<n-1)?",\n":"\n");
+  }
+   OutFmt( f, "%s","};\n");
+}
+
+/* closure as packed bit rows: bit t2 of row t1; in flash, bits are read by bytes of little-endian words */
+void prnBitRowsC( struct net * net, struct obuf * f, struct ctabs * ts, uint64_t *R, int n, int nw )
+{
+  int i,j;
+  char dims[32];
+  struct ctab * c;
+
+  c=CTab( net, ts, "r", 0, 0, (long long)((n>0)?n:1)*((nw>0)?nw:1), 1 );
+  if( net->opt.narrow ) { strcpy( c->type, "uint64_t" ); c->size=8; } else strcpy( c->type, "unsigned long long" );
+  OutFmt( f, "// priority arcs connecting transitions, transitive closure as bit rows\n");
+  OutFmt( f, "#define nrw %d\n", (nw>0)?nw:1 );
+  sprintf( dims, "[%d][%d]", (n>0)?n:1, (nw>0)?nw:1 );
+  CTabDecl( f, c, dims ); OutStr( f, "\n{\n" );
+  if( n==0 || nw==0 ) OutFmt( f, "{0}\n" );
+  for(i=0;i<n;i++)
+  {
+  	OutFmt( f, "%c",'{');
+  	for(j=0;j<nw;j++)
+  		OutFmt( f, "0x%llxULL%c", (unsigned long long)BITROW(R,i,nw)[j], (j<nw-1)?',':'}' );
+	OutFmt( f, "%s",(i<n-1)?",\n":"\n");
+  }
+  OutFmt( f, "%s","};\n");
+  if( c->flash ) OutFmt( f, "#define R_BIT(t1,t2) ((int)((SN_PGM1((const uint8_t *)r[t1]+((t2)>>3))>>((t2)&7))&1))\n");
+    else OutFmt( f, "#define R_BIT(t1,t2) ((int)((r[t1][(t2)>>6]>>((t2)&63))&1))\n");
+}
+
+
+void WriteDepends_h( struct net * net, struct obuf * f, struct ctabs * ts );
+void DenseArcs( struct net * net, char * what );
+
+void WriteSN_matr_h( struct net * net, struct obuf * f )
+{
+  int i,p,nw; 
+  int * x;
+  uint64_t * R;
+  long long lo, hi;
+  char dims[32];
+  struct ctabs ts;
+  struct ctab *cb, *cd, *cr=NULL, *cmu;
+  
+  DenseArcs( net, "dense matrix b" );
+  x=malloc(MATRIX_SIZE(net->m,net->n,int));
+  if( x==NULL ) NetError( net, 3, "not enough memory (WriteSN_matr_h)" );
+  ts.k=0;
+   
+  OutFmt( f, "// SN obtained from NDR\n");
+  OutFmt( f, "#define m %d\n#define n %d\n", net->m, net->n);
+  CTabHead( net, f );
+  sprintf( dims, "[%d][%d]", net->m, net->n );
+  memset(x,0,MATRIX_SIZE(net->m,net->n,int));
+  for( i=0; i<net->fapt; i++ )
+    MELT(x,(net->aptp[i]-1),(net->aptt[i]-1),net->m,net->n)=(net->aptw[i]>0)?net->aptw[i]:-1;
+    //OutFmt( f, "%d %d %d\n", aptp[i], aptt[i], (aptw[i]>0)?aptw[i]:-1 );
+  CRange( x, (long long)net->m*net->n, &lo, &hi );
+  cb=CTab( net, &ts, "b", lo, hi, (long long)net->m*net->n, 1 );
+  OutFmt( f, "// incoming arcs of transitions\n"); CTabDecl( f, cb, dims ); OutStr( f, "\n" );
+  prnMartC(f,x,net->m,net->n);
+ 
+  memset(x,0,MATRIX_SIZE(net->m,net->n,int));
+  for( i=0; i<net->fatp; i++ )
+    MELT(x,(net->atpp[i]-1),(net->atpt[i]-1),net->m,net->n)=net->atpw[i];
+    //OutFmt( f, "%d %d %d\n", -atpp[i], atpt[i], atpw[i] );
+  CRange( x, (long long)net->m*net->n, &lo, &hi );
+  cd=CTab( net, &ts, "d", lo, hi, (long long)net->m*net->n, 1 );
+  OutFmt( f, "// outgoing arcs of transitions\n"); CTabDecl( f, cd, dims ); OutStr( f, "\n" );
+  prnMartC(f,x,net->m,net->n);
+    
+  /*OutFmt( f, "; t->t: -t1 -t2 0\n");    
+  for( i=0; i<fatt; i++ )
+  OutFmt( f, "%d %d %d\n", -att1[i], -att2[i], 0 );*/
+    
+  free(x);
+  R=PriorityBits( net, &nw );
+  if( net->opt.rbits ) prnBitRowsC( net, f, &ts, R, net->n, nw ); else
+  {
+  cr=CTab( net, &ts, "r", 0, 1, (long long)net->n*net->n, 1 );
+  sprintf( dims, "[%d][%d]", net->n, net->n );
+  OutFmt( f, "// priority arcs connecting transitions, transitive closure\n"); CTabDecl( f, cr, dims ); OutStr( f, "\n" );
+  prnBitMartC(f,R,net->n,nw);
+  }
+  free(R);
+  cmu=CTabMu( net, &ts );
+  sprintf( dims, "[%d]", net->m );
+  OutFmt( f, "// initial marking\n"); CTabDecl( f, cmu, dims ); OutStr( f, "{" );
+  for( p=1; p<=net->m; p++ )
+  {
+  	OutFmt( f, "%d", net->mu[p] );
+  	OutFmt( f, "%c",(p<net->m)?',':'}');
+  }
+  OutFmt( f, ";\n");
+  if( net->opt.narrow )
+  {
+    OutFmt( f, "// access to arcs\n");
+    CTabMacro( f, cb, "B_AT(p,t)", "b[p][t]" );
+    CTabMacro( f, cd, "D_AT(p,t)", "d[p][t]" );
+    if( cr!=NULL ) CTabMacro( f, cr, "R_AT(t1,t2)", "r[t1][t2]" );
+  }
+  WriteDepends_h( net, f, &ts );
+  CTabReport( net, f, &ts );
+      
+  /*if(l>0) 
+  {
+     ProcessHSNlabels( f );
+  }*/
+  
+  OutFmt( f, "// Table of places\n// no\tname\n");
+  WriteNMP_matr_h( net, f );
+  
+  OutFmt( f, "// Table of transitions\n// no\tname\n");
+  WriteNMT_matr_h( net, f );
+  
+  OutFmt( f, "// end of SN\n");
+
+}/* WriteSN_matr_h */
+
+/* groups arcs by transition into row pointers ptr[n+1] of 0-based places cp[] and weights cw[];
+   repeated arcs keep the last weight as the dense matrix does; with inh, arcs of weight <=0 are inhibitor arcs -1,
+   which are kept once besides a regular arc between the same nodes; returns number of entries */
+int GroupArcs( struct net * net, int na, int *ap, int *at, int *aw, int inh, int *ptr, int *cp, int *cw )
+{
+  int i, j, k, t, p, q, w, gend, nm=((net->m>net->n)?net->m:net->n)+1;
+  int *gptr, *order, *mark;
+
+  gptr = (int*) calloc( net->n+1, sizeof(int) );
+  order = (int*) malloc( (na+1) * sizeof(int) );
+  mark = (int*) calloc( 2*nm, sizeof(int) );
+  if( gptr==NULL || order==NULL || mark==NULL )
+    NetError( net, 3, "not enough memory (GroupArcs)" );
+
+  /* counting sort by transition, stable */
+  for( i=0; i<na; i++ ) gptr[ at[i] ]++;
+  for( t=1; t<=net->n; t++ ) gptr[t]+=gptr[t-1];
+  for( i=na-1; i>=0; i-- ) order[ --gptr[ at[i] ] ]=i;
+
+  k=0;
+  for( t=1; t<=net->n; t++ )
+  {
+    ptr[t-1]=k;
+    gend=(t<net->n)? gptr[t+1]: na;
+    for( j=gptr[t]; j<gend; j++ )
+    {
+      i=order[j]; p=ap[i];
+      w=(aw==NULL)? 1: aw[i];
+      q=p;
+      if( inh && w<=0 ) { w=-1; q=p+nm; }
+      if( mark[q] > ptr[t-1] ) { if( cw!=NULL ) cw[ mark[q]-1 ]=w; }
+      else { cp[k]=p-1; if( cw!=NULL ) cw[k]=w; mark[q]=++k; }
+    }
+  }
+  ptr[net->n]=k;
+
+  free( gptr ); free( order ); free( mark );
+  return( k );
+
+} /* GroupArcs */
+
+/* fails when a place has both regular and inhibitor arcs to a transition: one cell of matrix what holds one of them */
+void DenseArcs( struct net * net, char * what )
+{
+  int *bptr, *bp, *mark, k, p, t;
+
+  bptr = (int*) malloc( (net->n+1) * sizeof(int) );
+  bp = (int*) malloc( (net->fapt+1) * sizeof(int) );
+  mark = (int*) calloc( net->m+1, sizeof(int) );
+  if( bptr==NULL || bp==NULL || mark==NULL ) NetError( net, 3, "not enough memory (DenseArcs)" );
+  GroupArcs( net, net->fapt, net->aptp, net->aptt, net->aptw, 1, bptr, bp, NULL );
+  for( t=0; t<net->n; t++ )
+    for( k=bptr[t]; k<bptr[t+1]; k++ )
+    {
+      p=bp[k];
+      if( mark[p]==t+1 )
+      {
+        free( bptr ); free( bp ); free( mark );
+        NetError( net, 4, "regular and inhibitor arcs %s -> %s do not fit %s, use -s", NodeName( net, p+1 ), NodeName( net, -(t+1) ), what );
+      }
+      mark[p]=t+1;
+    }
+  free( bptr ); free( bp ); free( mark );
+
+} /* DenseArcs */
+
+/* consumers of places: rows cptr[m+1] of 0-based transitions ct[] having input or inhibitor arcs
+   from place p, in order of transitions, each once; bptr/bp are input arcs grouped by transition, cptr has m+2 entries */
+void ConsumersCSR( struct net * net, int *bptr, int *bp, int *cptr, int *ct )
+{
+  int k, p, t, *last;
+
+  last = (int*) malloc( (net->m+1) * sizeof(int) );
+  if( last==NULL ) NetError( net, 3, "not enough memory (ConsumersCSR)" );
+  memset( cptr, 0, (net->m+2)*sizeof(int) );
+  for( p=0; p<net->m; p++ ) last[p]=-1;
+  for( t=0; t<net->n; t++ )
+    for( k=bptr[t]; k<bptr[t+1]; k++ )
+      if( last[ bp[k] ]!=t ) { last[ bp[k] ]=t; cptr[ bp[k]+1 ]++; }
+  for( p=0; p<net->m; p++ ) cptr[p+1]+=cptr[p];
+  for( p=0; p<net->m; p++ ) last[p]=-1;
+  for( t=0; t<net->n; t++ )
+    for( k=bptr[t]; k<bptr[t+1]; k++ )
+      if( last[ bp[k] ]!=t ) { last[ bp[k] ]=t; ct[ cptr[ bp[k] ]++ ]=t; }
+  for( p=net->m; p>0; p-- ) cptr[p]=cptr[p-1];
+  cptr[0]=0;
+  free( last );
+
+} /* ConsumersCSR */
+
+/* index of transitions whose enabling depends on places: rows dptr[m+1] of 0-based transitions *pdt;
+   dptr has m+2 entries; returns number of entries */
+int DependIndex( struct net * net, int *dptr, int **pdt )
+{
+  int *bptr, *bp, *dt, nb;
+
+  bptr = (int*) malloc( (net->n+1) * sizeof(int) );
+  bp = (int*) malloc( (net->fapt+1) * sizeof(int) );
+  if( bptr==NULL || bp==NULL ) NetError( net, 3, "not enough memory (DependIndex)" );
+  nb=GroupArcs( net, net->fapt, net->aptp, net->aptt, NULL, 0, bptr, bp, NULL );
+  dt = (int*) malloc( (nb+1) * sizeof(int) );
+  if( dt==NULL ) NetError( net, 3, "not enough memory (DependIndex)" );
+  ConsumersCSR( net, bptr, bp, dptr, dt );
+  free( bptr ); free( bp );
+  *pdt=dt;
+  return( nb );
+
+} /* DependIndex */
+
+/* LSN comment lines ";& p k t1 ... tk" for p=1..m: the k transitions having input or inhibitor arcs from p */
+void WriteDepends( struct net * net, struct obuf * f )
+{
+  int *dptr, *dt, p, k;
+
+  dptr = (int*) malloc( (net->m+2) * sizeof(int) );
+  if( dptr==NULL ) NetError( net, 3, "not enough memory (WriteDepends)" );
+  DependIndex( net, dptr, &dt );
+  OutFmt( f, "; transitions depending on places p=1..m: p k t1 .. tk\n");
+  for( p=0; p<net->m; p++ )
+  {
+    OutFmt( f, ";& %d %d", p+1, dptr[p+1]-dptr[p] );
+    for( k=dptr[p]; k<dptr[p+1]; k++ ) OutFmt( f, " %d", dt[k]+1 );
+    OutStr( f, "\n" );
+  }
+  free( dptr ); free( dt );
+
+} /* WriteDepends */
+
+int CompareInt( const void * a, const void * b )
+{
+  return( (*(int*)a > *(int*)b) - (*(int*)a < *(int*)b) );
+
+} /* CompareInt */
+
+/* transitive closure of priority arcs as rows rptr[n+1] of 0-based transitions *prt; returns number of entries */
+int PriorityClosureCSR( struct net * net, int *rptr, int **prt )
+{
+  int t, u, v, j, k, sp, maxr;
+  int *aptr, *adj, *vis, *stack, *rt, *newrt;
+  double t0=WallTime(), c0=( net->opt.stats )? CpuTime(): 0;
+
+  aptr = (int*) malloc( (net->n+1) * sizeof(int) );
+  adj = (int*) malloc( (net->fatt+1) * sizeof(int) );
+  vis = (int*) calloc( net->n+1, sizeof(int) );
+  stack = (int*) malloc( (net->n+1) * sizeof(int) );
+  maxr=net->fatt+net->n+1;
+  rt = (int*) malloc( maxr * sizeof(int) );
+  if( aptr==NULL || adj==NULL || vis==NULL || stack==NULL || rt==NULL )
+    NetError( net, 3, "not enough memory (PriorityClosureCSR)" );
+
+  GroupArcs( net, net->fatt, net->att2, net->att1, NULL, 0, aptr, adj, NULL );
+
+  k=0;
+  for( t=0; t<net->n; t++ )
+  {
+    rptr[t]=k;
+    sp=0; stack[ sp++ ]=t;
+    while( sp>0 )
+    {
+      u=stack[ --sp ];
+      for( j=aptr[u]; j<aptr[u+1]; j++ )
+      {
+        v=adj[j];
+        if( vis[v]==t+1 ) continue;
+        vis[v]=t+1;
+        if( k>=maxr )
+        {
+          maxr*=2;
+          newrt = (int*) realloc( rt, maxr * sizeof(int) );
+          if( newrt==NULL ) NetError( net, 3, "not enough memory (PriorityClosureCSR)" );
+            else rt=newrt;
+        }
+        rt[ k++ ]=v;
+        stack[ sp++ ]=v;
+      }
+    }
+    qsort( rt+rptr[t], k-rptr[t], sizeof(int), CompareInt );
+  }
+  rptr[net->n]=k;
+
+  free( aptr ); free( adj ); free( vis ); free( stack );
+  *prt=rt;
+  PhaseEnd( net, PH_CLOSURE, &t0, &c0 );
+  return( k );
+
+} /* PriorityClosureCSR */
+
+void prnArrC( struct obuf * f, int *x, int k )
+{
+  int i;
+
+  if( k==0 ) { OutFmt( f, "{0};\n" ); return; }
+  OutFmt( f, "%c", '{' );
+  for( i=0; i<k; i++ )
+  {
+    OutInt( f, x[i] );
+    OutStr( f, (i<k-1)? ( (i%32==31)? ",\n": "," ): "};\n" );
+  }
+
+} /* prnArrC */
+
+/* C header arrays of transitions depending on places, with deps */
+void WriteDepends_h( struct net * net, struct obuf * f, struct ctabs * ts )
+{
+  int *dptr, *dt, nc;
+  char dims[32];
+  struct ctab *cptr, *ct;
+
+  if( ! net->opt.deps ) return;
+  dptr = (int*) malloc( (net->m+2) * sizeof(int) );
+  if( dptr==NULL ) NetError( net, 3, "not enough memory (WriteDepends_h)" );
+  nc=DependIndex( net, dptr, &dt );
+  cptr=CTab( net, ts, "dep_ptr", 0, nc, net->m+1, 1 );
+  ct=CTab( net, ts, "dep_t", 0, (net->n>0)?net->n-1:0, (nc>0)?nc:1, 1 );
+  OutFmt( f, "// transitions depending on place p: transition dep_t[k], k=dep_ptr[p]..dep_ptr[p+1]-1\n");
+  OutFmt( f, "#define ndep %d\n", nc );
+  sprintf( dims, "[%d]", net->m+1 ); CTabDecl( f, cptr, dims ); OutStr( f, "\n" ); prnArrC( f, dptr, net->m+1 );
+  sprintf( dims, "[%d]", (nc>0)?nc:1 ); CTabDecl( f, ct, dims ); OutStr( f, "\n" ); prnArrC( f, dt, nc );
+  CTabFor( f, cptr, "DEP_FOR", "p" );
+  CTabMacro( f, ct, "DEP_T(k)", "dep_t[k]" );
+  free( dptr ); free( dt );
+
+} /* WriteDepends_h */
+
+void WriteSN_sparse_h( struct net * net, struct obuf * f )
+{
+  int nb, nd, nr, nw;
+  uint64_t *R=NULL;
+  int *bptr, *bp, *bw, *dptr, *dp, *dw, *rptr, *rt;
+  long long lo, hi;
+  char dims[32];
+  struct ctabs ts;
+  struct ctab *cbptr, *cbp, *cbw, *cdptr, *cdp, *cdw, *crptr=NULL, *crt=NULL, *cmu;
+
+  bptr = (int*) malloc( (net->n+1) * sizeof(int) );
+  bp = (int*) malloc( (net->fapt+1) * sizeof(int) );
+  bw = (int*) malloc( (net->fapt+1) * sizeof(int) );
+  dptr = (int*) malloc( (net->n+1) * sizeof(int) );
+  dp = (int*) malloc( (net->fatp+1) * sizeof(int) );
+  dw = (int*) malloc( (net->fatp+1) * sizeof(int) );
+  rptr = (int*) malloc( (net->n+1) * sizeof(int) );
+  if( bptr==NULL || bp==NULL || bw==NULL || dptr==NULL || dp==NULL || dw==NULL || rptr==NULL )
+    NetError( net, 3, "not enough memory (WriteSN_sparse_h)" );
+
+  nb=GroupArcs( net, net->fapt, net->aptp, net->aptt, net->aptw, 1, bptr, bp, bw );
+  nd=GroupArcs( net, net->fatp, net->atpp, net->atpt, net->atpw, 0, dptr, dp, dw );
+  if( net->opt.rbits ) { nr=0; rt=NULL; R=PriorityBits( net, &nw ); } else nr=PriorityClosureCSR( net, rptr, &rt );
+
+  ts.k=0;
+  cbptr=CTab( net, &ts, "b_ptr", 0, nb, net->n+1, 1 );
+  cbp=CTab( net, &ts, "b_p", 0, (net->m>0)?net->m-1:0, (nb>0)?nb:1, 1 );
+  CRange( bw, nb, &lo, &hi ); cbw=CTab( net, &ts, "b_w", lo, hi, (nb>0)?nb:1, 1 );
+  cdptr=CTab( net, &ts, "d_ptr", 0, nd, net->n+1, 1 );
+  cdp=CTab( net, &ts, "d_p", 0, (net->m>0)?net->m-1:0, (nd>0)?nd:1, 1 );
+  CRange( dw, nd, &lo, &hi ); cdw=CTab( net, &ts, "d_w", lo, hi, (nd>0)?nd:1, 1 );
+
+  OutFmt( f, "// SN obtained from NDR, sparse form\n");
+  OutFmt( f, "#define m %d\n#define n %d\n", net->m, net->n);
+  OutFmt( f, "#define nb %d\n#define nd %d\n#define nr %d\n", nb, nd, nr);
+  CTabHead( net, f );
+
+  OutFmt( f, "// incoming arcs of transitions: place b_p[k], weight b_w[k], k=b_ptr[t]..b_ptr[t+1]-1\n");
+  sprintf( dims, "[%d]", net->n+1 ); CTabDecl( f, cbptr, dims ); OutStr( f, "\n" ); prnArrC( f, bptr, net->n+1 );
+  sprintf( dims, "[%d]", (nb>0)?nb:1 ); CTabDecl( f, cbp, dims ); OutStr( f, "\n" ); prnArrC( f, bp, nb );
+  CTabDecl( f, cbw, dims ); OutStr( f, "\n" ); prnArrC( f, bw, nb );
+
+  OutFmt( f, "// outgoing arcs of transitions: place d_p[k], weight d_w[k], k=d_ptr[t]..d_ptr[t+1]-1\n");
+  sprintf( dims, "[%d]", net->n+1 ); CTabDecl( f, cdptr, dims ); OutStr( f, "\n" ); prnArrC( f, dptr, net->n+1 );
+  sprintf( dims, "[%d]", (nd>0)?nd:1 ); CTabDecl( f, cdp, dims ); OutStr( f, "\n" ); prnArrC( f, dp, nd );
+  CTabDecl( f, cdw, dims ); OutStr( f, "\n" ); prnArrC( f, dw, nd );
+
+  if( net->opt.rbits ) { prnBitRowsC( net, f, &ts, R, net->n, nw ); free( R ); } else
+  {
+  crptr=CTab( net, &ts, "r_ptr", 0, nr, net->n+1, 1 );
+  crt=CTab( net, &ts, "r_t", 0, (net->n>0)?net->n-1:0, (nr>0)?nr:1, 1 );
+  OutFmt( f, "// priority arcs connecting transitions, transitive closure: transition r_t[k], k=r_ptr[t]..r_ptr[t+1]-1\n");
+  sprintf( dims, "[%d]", net->n+1 ); CTabDecl( f, crptr, dims ); OutStr( f, "\n" ); prnArrC( f, rptr, net->n+1 );
+  sprintf( dims, "[%d]", (nr>0)?nr:1 ); CTabDecl( f, crt, dims ); OutStr( f, "\n" ); prnArrC( f, rt, nr );
+  }
+
+  cmu=CTabMu( net, &ts );
+  sprintf( dims, "[%d]", net->m );
+  OutFmt( f, "// initial marking\n"); CTabDecl( f, cmu, dims ); OutStr( f, "\n" );
+  prnArrC( f, net->mu+1, net->m );
+
+  OutFmt( f, "// access to arcs of transition t\n");
+  OutFmt( f, "#define SN_SPARSE\n");
+  CTabFor( f, cbptr, "B_FOR", "t" );
+  CTabFor( f, cdptr, "D_FOR", "t" );
+  if( ! net->opt.rbits ) CTabFor( f, crptr, "R_FOR", "t" );
+  CTabMacro( f, cbp, "B_P(k)", "b_p[k]" ); CTabMacro( f, cbw, "B_W(k)", "b_w[k]" );
+  CTabMacro( f, cdp, "D_P(k)", "d_p[k]" ); CTabMacro( f, cdw, "D_W(k)", "d_w[k]" );
+  if( ! net->opt.rbits ) CTabMacro( f, crt, "R_T(k)", "r_t[k]" );
+  WriteDepends_h( net, f, &ts );
+  CTabReport( net, f, &ts );
+
+  OutFmt( f, "// Table of places\n// no\tname\n");
+  WriteNMP_matr_h( net, f );
+  
+  OutFmt( f, "// Table of transitions\n// no\tname\n");
+  WriteNMT_matr_h( net, f );
+  
+  OutFmt( f, "// end of SN\n");
+
+  free( bptr ); free( bp ); free( bw );
+  free( dptr ); free( dp ); free( dw );
+  free( rptr ); if( rt!=NULL ) free( rt );
+
+}/* WriteSN_sparse_h */
+
+#define SN_ALIGN 64 /* bytes of alignment of tables and of rows of transposed matrices */
+
+/* dense C header with transposed matrices for vector VMs: rows of transitions bt[n][mp], dt[n][mp] over places
+   padded by zeros to a multiple of SN_ALIGN bytes, inhibitor arcs as bit rows ih[n][mw]; as for the sparse header,
+   a repeated arc between the same nodes keeps the last weight, an inhibitor arc is kept besides a regular one */
+void WriteSN_tmatr_h( struct net * net, struct obuf * f )
+{
+  int i, t, p, nw, mp, mw, es, maxb=0, maxd=0;
+  int *x;
+  uint64_t *R, *ih;
+  char dims[32];
+  struct ctabs ts;
+  struct ctab *cb, *cd, *ci, *cr=NULL, *cmu;
+
+  ts.k=0;
+  for( i=0; i<net->fapt; i++ ) if( net->aptw[i]>maxb ) maxb=net->aptw[i];
+  for( i=0; i<net->fatp; i++ ) if( net->atpw[i]>maxd ) maxd=net->atpw[i];
+  cb=CTab( net, &ts, "bt", 0, maxb, 0, 1 );
+  cd=CTab( net, &ts, "dt", 0, maxd, 0, 1 );
+  ci=CTab( net, &ts, "ih", 0, 0, 0, 1 );
+  if( net->opt.narrow ) { strcpy( ci->type, "uint64_t" ); ci->size=8; } else strcpy( ci->type, "unsigned long long" );
+  es=( ! net->opt.narrow )? (int)sizeof(int): ( cb->size<cd->size )? cb->size: cd->size;
+  mp=( net->m+SN_ALIGN/es-1 )/( SN_ALIGN/es )*( SN_ALIGN/es ); if( mp==0 ) mp=SN_ALIGN/es;
+  mw=( ( net->m+63 )/64+SN_ALIGN/8-1 )/( SN_ALIGN/8 )*( SN_ALIGN/8 ); if( mw==0 ) mw=SN_ALIGN/8;
+  cb->count=cd->count=(long long)((net->n>0)?net->n:1)*mp; ci->count=(long long)((net->n>0)?net->n:1)*mw;
+  cb->aligned=cd->aligned=ci->aligned=1;
+
+  x=(int*) calloc( (size_t)((net->n>0)?net->n:1)*mp, sizeof(int) );
+  ih=(uint64_t*) calloc( (size_t)((net->n>0)?net->n:1)*mw, sizeof(uint64_t) );
+  if( x==NULL || ih==NULL ) NetError( net, 3, "not enough memory (WriteSN_tmatr_h)" );
+
+  OutFmt( f, "// SN obtained from NDR, transposed dense form\n");
+  OutFmt( f, "#define m %d\n#define n %d\n", net->m, net->n);
+  OutFmt( f, "// places padded to rows of SN_ALIGN bytes, 64-bit words of rows of inhibitor arcs\n");
+  OutFmt( f, "#define mp %d\n#define mw %d\n#define SN_ALIGN %d\n#define SN_TRANSPOSED\n", mp, mw, SN_ALIGN );
+  OutFmt( f, "#if defined(__GNUC__)\n#define SN_ALIGNED __attribute__((aligned(SN_ALIGN)))\n#else\n#define SN_ALIGNED\n#endif\n");
+  CTabHead( net, f );
+
+  for( i=0; i<net->fapt; i++ )
+  {
+    t=net->aptt[i]-1; p=net->aptp[i]-1;
+    if( net->aptw[i]>0 ) x[ (size_t)t*mp+p ]=net->aptw[i]; else SETBIT( ih, t, p, mw );
+  }
+  sprintf( dims, "[%d][%d]", (net->n>0)?net->n:1, mp );
+  OutFmt( f, "// incoming arcs of transitions: weight bt[t][p], 0 for inhibitor arcs\n"); CTabDecl( f, cb, dims ); OutStr( f, "\n" );
+  if( net->n>0 ) prnMartC( f, x, net->n, mp ); else OutFmt( f, "{{0}};\n" );
+
+  OutFmt( f, "// inhibitor arcs of transitions: bit p of row t\n");
+  sprintf( dims, "[%d][%d]", (net->n>0)?net->n:1, mw ); CTabDecl( f, ci, dims ); OutStr( f, "\n{\n" );
+  if( net->n==0 ) OutFmt( f, "{0}\n" );
+  for( t=0; t<net->n; t++ )
+  {
+    OutChar( f, '{' );
+    for( i=0; i<mw; i++ ) OutFmt( f, "0x%llxULL%c", (unsigned long long)BITROW(ih,t,mw)[i], (i<mw-1)?',':'}' );
+    OutStr( f, (t<net->n-1)? ",\n": "\n" );
+  }
+  OutStr( f, "};\n" );
+  if( ci->flash ) OutFmt( f, "#define IH_BIT(t,p) ((int)((SN_PGM1((const uint8_t *)ih[t]+((p)>>3))>>((p)&7))&1))\n");
+    else OutFmt( f, "#define IH_BIT(t,p) ((int)((ih[t][(p)>>6]>>((p)&63))&1))\n");
+
+  memset( x, 0, (size_t)((net->n>0)?net->n:1)*mp*sizeof(int) );
+  for( i=0; i<net->fatp; i++ ) x[ (size_t)(net->atpt[i]-1)*mp+net->atpp[i]-1 ]=net->atpw[i];
+  sprintf( dims, "[%d][%d]", (net->n>0)?net->n:1, mp );
+  OutFmt( f, "// outgoing arcs of transitions: weight dt[t][p]\n"); CTabDecl( f, cd, dims ); OutStr( f, "\n" );
+  if( net->n>0 ) prnMartC( f, x, net->n, mp ); else OutFmt( f, "{{0}};\n" );
+
+  R=PriorityBits( net, &nw );
+  if( net->opt.rbits ) prnBitRowsC( net, f, &ts, R, net->n, nw ); else
+  {
+  cr=CTab( net, &ts, "r", 0, 1, (long long)net->n*net->n, 1 );
+  sprintf( dims, "[%d][%d]", net->n, net->n );
+  OutFmt( f, "// priority arcs connecting transitions, transitive closure\n"); CTabDecl( f, cr, dims ); OutStr( f, "\n" );
+  prnBitMartC(f,R,net->n,nw);
+  }
+  free( R );
+
+  memset( x, 0, mp*sizeof(int) );
+  for( p=0; p<net->m; p++ ) x[p]=net->mu[p+1];
+  cmu=CTabMu( net, &ts ); cmu->count=mp; cmu->aligned=1;
+  sprintf( dims, "[%d]", mp );
+  OutFmt( f, "// initial marking, padded\n"); CTabDecl( f, cmu, dims ); OutStr( f, "\n" );
+  prnArrC( f, x, mp );
+  if( net->opt.narrow )
+  {
+    OutFmt( f, "// access to arcs\n");
+    CTabMacro( f, cb, "BT_AT(t,p)", "bt[t][p]" );
+    CTabMacro( f, cd, "DT_AT(t,p)", "dt[t][p]" );
+    if( cr!=NULL ) CTabMacro( f, cr, "R_AT(t1,t2)", "r[t1][t2]" );
+  }
+  WriteDepends_h( net, f, &ts );
+  CTabReport( net, f, &ts );
+
+  OutFmt( f, "// Table of places\n// no\tname\n");
+  WriteNMP_matr_h( net, f );
+  
+  OutFmt( f, "// Table of transitions\n// no\tname\n");
+  WriteNMT_matr_h( net, f );
+  
+  OutFmt( f, "// end of SN\n");
+
+  free( x ); free( ih );
+
+}/* WriteSN_tmatr_h */
+
+/* MSN: matrices of SN-VM-GPU by transition rows; dense rows are padded with zeros to msnALIGN values */
+#define msnALIGN 32
+#define ALIGNUP(x,a) ((((x)+(a)-1)/(a))*(a))
+
+/* writes section of rows of matrix cols wide given by row pointers ptr, 0-based columns col, values val (NULL - ones);
+   the section is dense when it is not larger than the sparse one */
+void WriteMSNSection( struct net * net, struct obuf * f, char * title, int rows, int cols, int *ptr, int *col, int *val )
+{
+  int i, k, ld, nnz=ptr[rows];
+  int *x;
+
+  ld=ALIGNUP( (cols>0)?cols:1, msnALIGN );
+  OutFmt( f, "; %s\n", title );
+  if( (double)rows*ld <= (double)rows+1+2.0*nnz )
+  {
+    OutFmt( f, "dense %d %d %d\n", rows, cols, ld );
+    x=(int*) calloc( ld, sizeof(int) );
+    if( x==NULL ) NetError( net, 3, "not enough memory (WriteMSNSection)" );
+    for( i=0; i<rows; i++ )
+    {
+      for( k=ptr[i]; k<ptr[i+1]; k++ ) x[ col[k] ]=( val!=NULL )? val[k]: 1;
+      for( k=0; k<ld; k++ ) { OutInt( f, x[k] ); OutChar( f, ( k<ld-1 )? ' ': '\n' ); }
+      for( k=ptr[i]; k<ptr[i+1]; k++ ) x[ col[k] ]=0;
+    }
+    free( x );
+  }
+  else
+  {
+    OutFmt( f, "sparse %d %d %d\n", rows, cols, nnz );
+    for( i=0; i<=rows; i++ ) { OutInt( f, ptr[i] ); OutChar( f, ( i<rows )? ' ': '\n' ); }
+    for( i=0; i<rows; i++ )
+    {
+      for( k=ptr[i]; k<ptr[i+1]; k++ )
+      {
+        OutInt( f, col[k] ); OutChar( f, ' ' );
+        OutInt( f, ( val!=NULL )? val[k]: 1 ); OutChar( f, ( k<ptr[i+1]-1 )? ' ': '\n' );
+      }
+      if( ptr[i]==ptr[i+1] ) OutChar( f, '\n' );
+    }
+  }
+
+} /* WriteMSNSection */
+
+void WriteMSN( struct net * net, struct obuf * f )
+{
+  int p;
+  int *bptr, *bp, *bw, *dptr, *dp, *dw, *rptr, *rt, mptr[2], *mp, *mv;
+
+  if( net->nhst>0 ) NetError( net, 4, "MSN is written for LSN, use --flatten for HSN" );
+  DenseArcs( net, "MSN matrix B" );
+  bptr = (int*) malloc( (net->n+1) * sizeof(int) );
+  bp = (int*) malloc( (net->fapt+1) * sizeof(int) );
+  bw = (int*) malloc( (net->fapt+1) * sizeof(int) );
+  dptr = (int*) malloc( (net->n+1) * sizeof(int) );
+  dp = (int*) malloc( (net->fatp+1) * sizeof(int) );
+  dw = (int*) malloc( (net->fatp+1) * sizeof(int) );
+  rptr = (int*) malloc( (net->n+1) * sizeof(int) );
+  mp = (int*) malloc( (net->m+1) * sizeof(int) );
+  mv = (int*) malloc( (net->m+1) * sizeof(int) );
+  if( bptr==NULL || bp==NULL || bw==NULL || dptr==NULL || dp==NULL || dw==NULL || rptr==NULL || mp==NULL || mv==NULL )
+    NetError( net, 3, "not enough memory (WriteMSN)" );
+
+  GroupArcs( net, net->fapt, net->aptp, net->aptt, net->aptw, 1, bptr, bp, bw );
+  GroupArcs( net, net->fatp, net->atpp, net->atpt, net->atpw, 0, dptr, dp, dw );
+  PriorityClosureCSR( net, rptr, &rt );
+  mptr[0]=0; mptr[1]=0;
+  for( p=1; p<=net->m; p++ )
+    if( net->mu[p]!=0 ) { mp[ mptr[1] ]=p-1; mv[ mptr[1]++ ]=net->mu[p]; }
+
+  OutFmt( f, "; MSN obtained from NDR\n; m n align\n%d %d %d\n", net->m, net->n, msnALIGN );
+  WriteMSNSection( net, f, "mu: initial marking", 1, net->m, mptr, mp, mv );
+  WriteMSNSection( net, f, "B: incoming arcs of transitions, row t column p, inhibitor -1", net->n, net->m, bptr, bp, bw );
+  WriteMSNSection( net, f, "D: outgoing arcs of transitions, row t column p", net->n, net->m, dptr, dp, dw );
+  WriteMSNSection( net, f, "R: priority closure, row t column t1 of lower priority", net->n, net->n, rptr, rt, NULL );
+
+  OutFmt( f, "; Table of places\n; no name\n");
+  WriteNMP( net, f );
+  OutFmt( f, "; Table of transitions\n; no name\n");
+  WriteNMT( net, f );
+  OutFmt( f, "; end of MSN\n");
+
+  free( bptr ); free( bp ); free( bw );
+  free( dptr ); free( dp ); free( dw );
+  free( rptr ); free( rt ); free( mp ); free( mv );
+
+} /* WriteMSN */
+
+
+/* list of transitions of the condition of a step: " || c[t]" each, 16 per line */
+void OutCodeList( struct obuf * f, int *x, int k )
+{
+  int i;
+
+  for( i=0; i<k; i++ )
+  {
+    if( i>0 ) OutStr( f, ( i%16==0 )? " ||\n      ": " || " );
+    OutFmt( f, "sn_cm[%d]", x[i] );
+  }
+
+} /* OutCodeList */
+
+/* C header of straight-line firing code: for each transition t, sn_c<t>() computes its multiplicity
+   from its own input places and sn_f<t>(c) moves the tokens of its own arcs; sn_step() fires as the VM does
+   the first enabled transition which no enabled transition of higher priority blocks;
+   with deps, multiplicities are kept between steps and sn_f<t>() recomputes those of the transitions
+   depending on the places it changes */
+void WriteSN_code_h( struct net * net, struct obuf * f )
+{
+  int t, k, j, u, nh, nr, first;
+  int *bptr, *bp, *bw, *dptr, *dp, *dw, *rptr, *rt, *hptr, *ht, *cptr=NULL, *ct=NULL, *stamp=NULL;
+
+  if( net->nhst>0 ) NetError( net, 4, "code is written for LSN, use --flatten for HSN" );
+  bptr = (int*) malloc( (net->n+1) * sizeof(int) );
+  bp = (int*) malloc( (net->fapt+1) * sizeof(int) );
+  bw = (int*) malloc( (net->fapt+1) * sizeof(int) );
+  dptr = (int*) malloc( (net->n+1) * sizeof(int) );
+  dp = (int*) malloc( (net->fatp+1) * sizeof(int) );
+  dw = (int*) malloc( (net->fatp+1) * sizeof(int) );
+  rptr = (int*) malloc( (net->n+1) * sizeof(int) );
+  hptr = (int*) calloc( net->n+2, sizeof(int) );
+  if( bptr==NULL || bp==NULL || bw==NULL || dptr==NULL || dp==NULL || dw==NULL || rptr==NULL || hptr==NULL )
+    NetError( net, 3, "not enough memory (WriteSN_code_h)" );
+
+  GroupArcs( net, net->fapt, net->aptp, net->aptt, net->aptw, 1, bptr, bp, bw );
+  GroupArcs( net, net->fatp, net->atpp, net->atpt, net->atpw, 0, dptr, dp, dw );
+  nh=PriorityClosureCSR( net, rptr, &rt );
+  /* transposed closure: transitions of higher priority */
+  ht = (int*) malloc( (nh+1) * sizeof(int) );
+  if( ht==NULL ) NetError( net, 3, "not enough memory (WriteSN_code_h)" );
+  for( k=0; k<nh; k++ ) hptr[ rt[k]+2 ]++;
+  for( t=0; t<net->n; t++ ) hptr[t+2]+=hptr[t+1];
+  for( u=0; u<net->n; u++ )
+    for( k=rptr[u]; k<rptr[u+1]; k++ ) ht[ hptr[ rt[k]+1 ]++ ]=u;
+  if( net->opt.deps )
+  {
+    cptr = (int*) malloc( (net->m+2) * sizeof(int) );
+    stamp = (int*) calloc( net->n+1, sizeof(int) );
+    if( cptr==NULL || stamp==NULL ) NetError( net, 3, "not enough memory (WriteSN_code_h)" );
+    DependIndex( net, cptr, &ct );
+  }
+
+  OutFmt( f, "// SN obtained from NDR, compiled into firing code of transitions\n");
+  OutFmt( f, "#define m %d\n#define n %d\n", net->m, net->n);
+  OutFmt( f, "#ifndef SN_INT\n#define SN_INT long\n#endif\n#define SN_UNBOUNDED (-1)\n");
+  OutFmt( f, "// initial marking\nstatic SN_INT mu[%d]=\n", (net->m>0)?net->m:1 );
+  prnArrC( f, net->mu+1, net->m );
+  OutFmt( f, "// multiplicities of transitions in a step\nstatic SN_INT sn_cm[%d];\n", (net->n>0)?net->n:1 );
+  OutFmt( f, "// the last sn_step()\nstatic int sn_last;\n");
+  if( net->opt.deps ) OutFmt( f, "// sn_cm is computed, set to 0 after changing mu\nstatic int sn_ready;\n");
+
+  for( t=0; t<net->n; t++ )
+  {
+    OutFmt( f, "// %d\t%s: multiplicity, 0 if disabled, SN_UNBOUNDED without input arcs\n", t, net->names+net->tn[t+1] );
+    OutFmt( f, "static SN_INT sn_c%d( void )\n{\n", t );
+    for( k=bptr[t], nr=0; k<bptr[t+1]; k++ ) if( bw[k]>0 ) nr++;
+    if( nr>1 ) OutStr( f, "  SN_INT c, x;\n\n" );
+    first=1;
+    for( k=bptr[t]; k<bptr[t+1]; k++ )
+      if( bw[k]<0 )
+      {
+        OutStr( f, ( first )? "  if( ": " || " );
+        OutFmt( f, "mu[%d]", bp[k] ); first=0;
+      }
+    if( ! first ) OutStr( f, " ) return( 0 );\n" );
+    first=1;
+    for( k=bptr[t]; k<bptr[t+1]; k++ )
+    {
+      if( bw[k]<0 ) continue;
+      OutStr( f, ( nr==1 )? "  return( ": ( first )? "  c=": "  x=" );
+      if( bw[k]==1 ) OutFmt( f, "mu[%d]", bp[k] ); else OutFmt( f, "mu[%d]/%d", bp[k], bw[k] );
+      OutStr( f, ( nr==1 )? " );\n": ( first )? ";\n": "; if( x<c ) c=x;\n" );
+      first=0;
+    }
+    if( nr==0 ) OutStr( f, "  return( SN_UNBOUNDED );\n" ); else if( nr>1 ) OutStr( f, "  return( c );\n" );
+    OutStr( f, "}\n" );
+  }
+  for( t=0; t<net->n; t++ )
+  {
+    OutFmt( f, "// %d\t%s: fires c times\n", t, net->names+net->tn[t+1] );
+    OutFmt( f, "static void sn_f%d( SN_INT c )\n{\n", t );
+    for( k=bptr[t]; k<bptr[t+1]; k++ )
+      if( bw[k]==1 ) OutFmt( f, "  mu[%d]-=c;\n", bp[k] );
+        else if( bw[k]>1 ) OutFmt( f, "  mu[%d]-=%d*c;\n", bp[k], bw[k] );
+    for( k=dptr[t]; k<dptr[t+1]; k++ )
+      if( dw[k]==1 ) OutFmt( f, "  mu[%d]+=c;\n", dp[k] ); else OutFmt( f, "  mu[%d]+=%d*c;\n", dp[k], dw[k] );
+    if( net->opt.deps ) /* consumers of changed places, each once */
+    {
+      for( k=bptr[t]; k<bptr[t+1]+dptr[t+1]-dptr[t]; k++ )
+      {
+        if( k<bptr[t+1] ) { if( bw[k]<0 ) continue; else u=bp[k]; } else u=dp[ dptr[t]+k-bptr[t+1] ];
+        for( j=cptr[u]; j<cptr[u+1]; j++ )
+          if( stamp[ ct[j] ]!=t+1 ) { stamp[ ct[j] ]=t+1; OutFmt( f, "  sn_cm[%d]=sn_c%d();\n", ct[j], ct[j] ); }
+      }
+    }
+    OutStr( f, "}\n" );
+  }
+
+  OutFmt( f, "// step: fires the first enabled transition, which no enabled transition of higher priority blocks,\n");
+  OutFmt( f, "// at its multiplicity; returns its number+1, 0 if none is fireable, -(number+1) if it is unbounded\n");
+  OutFmt( f, "static int sn_step( void )\n{\n");
+  if( net->opt.deps ) OutStr( f, "  if( ! sn_ready )\n  {\n" );
+  for( t=0; t<net->n; t++ ) OutFmt( f, ( net->opt.deps )? "    sn_cm[%d]=sn_c%d();\n": "  sn_cm[%d]=sn_c%d();\n", t, t );
+  if( net->opt.deps ) OutStr( f, "    sn_ready=1;\n  }\n" );
+  for( t=0; t<net->n; t++ )
+  {
+    OutFmt( f, "  if( sn_cm[%d]", t );
+    if( hptr[t+1]>hptr[t] )
+    {
+      OutStr( f, " && ! ( " ); OutCodeList( f, ht+hptr[t], hptr[t+1]-hptr[t] ); OutStr( f, " )" );
+    }
+    OutFmt( f, " )\n  {\n    if( sn_cm[%d]==SN_UNBOUNDED ) return( %d );\n    sn_f%d( sn_cm[%d] );\n    return( %d );\n  }\n", t, -(t+1), t, t, t+1 );
+  }
+  OutFmt( f, "  return( 0 );\n}\n");
+  OutFmt( f, "// runs at most limit steps, 0 - no limit, until no transition is fireable; returns number of steps\n");
+  OutFmt( f, "static long sn_run( long limit )\n{\n  long s=0;\n\n");
+  OutFmt( f, "  while( limit==0 || s<limit )\n  {\n    sn_last=sn_step();\n    if( sn_last<=0 ) break;\n    s++;\n  }\n  return( s );\n}\n");
+
+  OutFmt( f, "// Table of places\n// no\tname\n");
+  WriteNMP_matr_h( net, f );
+  
+  OutFmt( f, "// Table of transitions\n// no\tname\n");
+  WriteNMT_matr_h( net, f );
+  
+  OutFmt( f, "// end of SN\n");
+
+  free( bptr ); free( bp ); free( bw );
+  free( dptr ); free( dp ); free( dw );
+  free( rptr ); free( rt ); free( hptr ); free( ht );
+  if( net->opt.deps ) { free( cptr ); free( ct ); free( stamp ); }
+
+} /* WriteSN_code_h */
+
+/* format of file by extension: .net, .lsn/.hsn or .ndr */
+int FileFormat( char * FileName )
+{
+  int z=strlen( FileName );
+
+  if( z>4 && strcmp( FileName+z-4, ".net" )==0 ) return( NET );
+  if( z>4 && ( strcmp( FileName+z-4, ".lsn" )==0 || strcmp( FileName+z-4, ".hsn" )==0 ) ) return( LSN );
+  return( NDR );
+
+} /* FileFormat */
+
+void NetInit( struct net * net )
+{
+  memset( net, 0, sizeof(struct net) );
+  net->netname=-1;
+  net->errnet=net;
+
+} /* NetInit */
+
+/* frees net storage kept by the context between conversions, options are kept */
+void NetRelease( struct net * net )
+{
+ struct ndrtosn_options opt=net->opt;
+
+ NetFree( net, net->tn, net->maxn*sizeof(int) ); 
+ NetFree( net, net->tl, net->maxl*sizeof(int) ); NetFree( net, net->tltn, net->maxl*sizeof(int) );
+ NetFree( net, net->pn, net->maxm*sizeof(int) ); NetFree( net, net->mu, net->maxm*sizeof(int) );
+ NetFree( net, net->aptp, net->maxapt*sizeof(int) ); NetFree( net, net->aptw, net->maxapt*sizeof(int) ); NetFree( net, net->aptt, net->maxapt*sizeof(int) );
+ NetFree( net, net->atpp, net->maxatp*sizeof(int) ); NetFree( net, net->atpw, net->maxatp*sizeof(int) ); NetFree( net, net->atpt, net->maxatp*sizeof(int) );
+ NetFree( net, net->att1, net->maxatt*sizeof(int) ); NetFree( net, net->att2, net->maxatt*sizeof(int) );
+ NetFree( net, net->hidx, net->maxhidx*sizeof(int) );
+ NetFree( net, net->hst, net->maxhst*sizeof(int) ); NetFree( net, net->hnmp, net->maxhst*sizeof(int) ); NetFree( net, net->hsubn, net->maxhst*sizeof(int) );
+ NetFree( net, net->hmap1, net->maxhmap*sizeof(int) ); NetFree( net, net->hmap2, net->maxhmap*sizeof(int) );
+ NetFree( net, net->pr, net->maxpr*sizeof(int) );
+ FreeParse( net );
+ NetInit( net );
+ net->opt=opt;
+
+} /* NetRelease */
+
+static char * PhaseName[ NPHASE ]={ "load", "parse", "hsn", "closure", "write" };
+
+/* report of conversion: phase times, bytes, net size, storage; JSON goes beside output file, or on stderr for stdout */
+void StatsReport( struct net * net, char * NetFileName, char * LSNFileName )
+{
+  char buf[ 2048+2*FILENAMELEN ], fname[ FILENAMELEN+16 ];
+  struct rusage ru;
+  FILE * f;
+  int k, len;
+
+  getrusage( RUSAGE_SELF, &ru );
+  if( net->opt.stats==1 )
+  {
+    len=snprintf( buf, sizeof(buf), "stats %s -> %s\n%-8s %10s %10s\n", NetFileName, LSNFileName, "phase", "wall,s", "cpu,s" );
+    for( k=0; k<NPHASE; k++ )
+      len+=snprintf( buf+len, sizeof(buf)-len, "%-8s %10.6f %10.6f\n", PhaseName[k], net->ph[k], net->cpu[k] );
+    snprintf( buf+len, sizeof(buf)-len,
+      "bytes: read %zu, written %zu\n"
+      "net: places %d, transitions %d, arcs p->t %d, t->p %d, t->t %d, labels %d, substitutions %d\n"
+      "storage: peak %zu bytes, %zu reallocs of %zu bytes, peak resident %ld KB\n",
+      net->nnames, net->nout, net->m, net->n, net->fapt, net->fatp, net->fatt, net->l, net->nhst,
+      net->netpeak, net->nreallocs, net->reallocbytes, (long)ru.ru_maxrss );
+    fputs( buf, stderr );
+    return;
+  }
+  len=snprintf( buf, sizeof(buf), "{\n  \"input\": \"%s\",\n  \"output\": \"%s\",\n  \"phases\": {\n", NetFileName, LSNFileName );
+  for( k=0; k<NPHASE; k++ )
+    len+=snprintf( buf+len, sizeof(buf)-len, "    \"%s\": { \"wall_s\": %.6f, \"cpu_s\": %.6f }%s\n",
+                   PhaseName[k], net->ph[k], net->cpu[k], ( k<NPHASE-1 )? ",": "" );
+  snprintf( buf+len, sizeof(buf)-len,
+    "  },\n  \"bytes_read\": %zu,\n  \"bytes_written\": %zu,\n"
+    "  \"places\": %d,\n  \"transitions\": %d,\n  \"arcs_pt\": %d,\n  \"arcs_tp\": %d,\n  \"arcs_tt\": %d,\n"
+    "  \"labels\": %d,\n  \"substitutions\": %d,\n"
+    "  \"storage_peak_bytes\": %zu,\n  \"reallocs\": %zu,\n  \"realloc_bytes\": %zu,\n  \"peak_rss_kb\": %ld\n}\n",
+    net->nnames, net->nout, net->m, net->n, net->fapt, net->fatp, net->fatt, net->l, net->nhst,
+    net->netpeak, net->nreallocs, net->reallocbytes, (long)ru.ru_maxrss );
+  if( strcmp( LSNFileName, "-" )==0 || strncmp( LSNFileName, "/dev/", 5 )==0 ) { fputs( buf, stderr ); return; }
+  snprintf( fname, sizeof(fname), "%s.stats.json", LSNFileName );
+  f=fopen( fname, "w" );
+  if( f==NULL ) NetError( net, 2, "error open file %s", fname );
+  fputs( buf, f );
+  fclose( f );
+
+} /* StatsReport */
+
+/* loads net file, or buffer buf of len bytes, into context net and parses it, substitution labels included; returns format */
+int ReadNetFile( struct net * net, char * NetFileName, char * buf, size_t len, int format, double *t0, double *c0 )
+{
+ int em, en, eapt, eatp, eatt, eh, nc;
+
+ LoadInput( net, NetFileName, buf, len );
+ if( format==0 ) /* by magic or file extension */
+ {
+   if( net->nnames>=4 && memcmp( net->names, blsnMAGIC, 4 )==0 ) format=BLSN;
+     else format=FileFormat( NetFileName );
+ }
+
+ /* init net size from the input, parallel parse sizes arrays itself */
+ nc=ParseChunks( net, format );
+ if( format==BLSN || format==LSN || nc>1 ) { em=0; en=0; eapt=0; eatp=0; eatt=0; }
+   else EstimateNet( net, format, &em, &en, &eapt, &eatp, &eatt );
+ net->netname=-1;
+
+ /* allocate arrays */
+ NetGrow( net, (en>nINIT)? en+2: nINIT, &net->maxn, "ReadNetFile", &net->tn, NULL, NULL ); net->n=0;
+ NetGrow( net, lINIT, &net->maxl, "ReadNetFile", &net->tl, &net->tltn, NULL ); net->l=0;
+ NetGrow( net, (em>mINIT)? em+2: mINIT, &net->maxm, "ReadNetFile", &net->pn, &net->mu, NULL ); net->m=0;
+ NetGrow( net, (eapt>aptINIT)? eapt: aptINIT, &net->maxapt, "ReadNetFile", &net->aptp, &net->aptt, &net->aptw ); net->fapt=0;
+ NetGrow( net, (eatp>atpINIT)? eatp: atpINIT, &net->maxatp, "ReadNetFile", &net->atpp, &net->atpt, &net->atpw ); net->fatp=0;
+ NetGrow( net, (eatt>attINIT)? eatt: attINIT, &net->maxatt, "ReadNetFile", &net->att1, &net->att2, NULL ); net->fatt=0;
+ for( eh=hidxINIT; eh < 2*(em+en+1); eh*=2 );
+ if( eh > net->maxhidx )
+ {
+   NetFree( net, net->hidx, net->maxhidx*sizeof(int) );
+   net->hidx = (int*) NetRealloc( net, NULL, 0, eh*sizeof(int), "ReadNetFile" ); net->maxhidx=eh;
+ }
+ memset( net->hidx, 0, net->maxhidx*sizeof(int) ); net->fhidx=0;
+ net->nhst=0; net->nhmap=0;
+ PhaseEnd( net, PH_LOAD, t0, c0 );
+
+ if( nc>1 ) ParseParallel( net, format, nc );
+   else if( format==BLSN ) ReadBLSN( net ); else if( format==LSN ) ReadLSN( net );
+   else if( format==NET ) ReadNET( net ); else ReadNDR( net ); 
+ PhaseEnd( net, PH_PARSE, t0, c0 );
+ if( net->l>0 ) ProcessHSNlabels( net );
+ return( format );
+
+}/* ReadNetFile */
+
+/* subnets loaded for flattening: each file is read and flattened once */
+struct subnets {
+  char ** path;
+  struct net ** net;
+  char * busy; /* the subnet is being flattened */
+  int k, max;
+};
+
+static char * SubnetExt[]={ "", ".lsn", ".hsn", ".ndr", ".net", NULL };
+
+/* finds file of subnet name in directory of file from, then in current directory */
+void SubnetFile( struct net * net, char * from, char * name, char * path )
+{
+  struct stat st;
+  char * slash;
+  int d, e, dl;
+
+  slash=strrchr( from, '/' );
+  dl=( slash!=NULL )? slash-from+1: 0;
+  for( d=0; d<2; d++, dl=0 )
+    for( e=0; SubnetExt[e]!=NULL; e++ )
+    {
+      snprintf( path, FILENAMELEN+1, "%.*s%s%s", dl, from, name, SubnetExt[e] );
+      if( stat( path, &st )==0 && S_ISREG( st.st_mode ) ) return;
+    }
+  NetError( net, 2, "subnet %s not found", name );
+
+} /* SubnetFile */
+
+void Flatten( struct net * net, struct subnets * c, char * from );
+
+/* flattened subnet name referenced from file from of net */
+struct net * LoadSubnet( struct net * net, struct subnets * c, char * from, char * name )
+{
+  char path[ FILENAMELEN+1 ];
+  struct net * S;
+  double t0, c0;
+  int k;
+
+  SubnetFile( net, from, name, path );
+  for( k=0; k<c->k; k++ )
+    if( strcmp( c->path[k], path )==0 )
+    {
+      if( c->busy[k] ) NetError( net, 2, "recursive substitution of subnet %s", path );
+      return( c->net[k] );
+    }
+  if( c->k >= c->max )
+  {
+    c->max=( c->max>0 )? 2*c->max: 16;
+    c->path=(char**) realloc( c->path, c->max*sizeof(char*) );
+    c->net=(struct net**) realloc( c->net, c->max*sizeof(struct net*) );
+    c->busy=(char*) realloc( c->busy, c->max );
+    if( c->path==NULL || c->net==NULL || c->busy==NULL ) NetError( net, 3, "not enough memory (LoadSubnet)" );
+  }
+  S=(struct net*) malloc( sizeof(struct net) );
+  if( S==NULL ) NetError( net, 3, "not enough memory (LoadSubnet)" );
+  NetInit( S );
+  S->opt=net->opt; S->errnet=net->errnet;
+  k=c->k++;
+  c->path[k]=strdup( path ); c->net[k]=S; c->busy[k]=1;
+  if( c->path[k]==NULL ) NetError( net, 3, "not enough memory (LoadSubnet)" );
+  ReadNetFile( S, c->path[k], NULL, 0, 0, &t0, &c0 );
+  if( S->nhst>0 ) Flatten( S, c, c->path[k] );
+  c->busy[k]=0;
+  return( S );
+
+} /* LoadSubnet */
+
+/* substitutes transitions by their flattened subnets, depth-first:
+   mapped subnet places are fused with HSN places, which keep their marking; the other subnet places
+   and all subnet transitions are added with names "t.name"; arcs of substituted transitions are removed
+   and their priority arcs pass to the transitions of the subnet */
+void Flatten( struct net * net, struct subnets * c, char * from )
+{
+  struct net * S;
+  int k, i, j, t, p, n0, nt, w, nx=0, maxx=0;
+  int *sub, *tbase, *tcnt, *pmap, *tmap, *x1=NULL, *x2=NULL;
+  int a, a1, a2, b1, b2, u, v;
+
+  /* subnets are loaded first, so errors of their files leave nothing allocated here */
+  for( k=0; k<net->nhst; k++ ) LoadSubnet( net, c, from, net->names+net->hsubn[k] );
+  n0=net->n;
+  sub=(int*) calloc( n0+1, sizeof(int) );
+  tbase=(int*) malloc( (net->nhst+1)*sizeof(int) );
+  tcnt=(int*) malloc( (net->nhst+1)*sizeof(int) );
+  if( sub==NULL || tbase==NULL || tcnt==NULL ) NetError( net, 3, "not enough memory (Flatten)" );
+
+  for( k=0, j=0; k<net->nhst; j+=net->hnmp[k++] )
+  {
+    t=net->hst[k];
+    if( t<1 || t>n0 || sub[t] )
+    {
+      free( sub ); free( tbase ); free( tcnt );
+      NetError( net, 2, "invalid substitution of transition %d", t );
+    }
+    sub[t]=k+1;
+    S=LoadSubnet( net, c, from, net->names+net->hsubn[k] );
+    pmap=(int*) calloc( S->m+1, sizeof(int) );
+    if( pmap==NULL ) NetError( net, 3, "not enough memory (Flatten)" );
+    for( i=j; i<j+net->hnmp[k]; i++ )
+    {
+      a=abs( net->hmap1[i] ); p=abs( net->hmap2[i] );
+      if( a<1 || a>net->m || p<1 || p>S->m )
+      {
+        free( pmap ); free( sub ); free( tbase ); free( tcnt );
+        NetError( net, 2, "invalid place mapping %d %d", net->hmap1[i], net->hmap2[i] );
+      }
+      pmap[p]=a;
+    }
+    for( p=1; p<=S->m; p++ )
+      if( pmap[p]==0 )
+      {
+        ExpandP( net );
+        net->pn[ ++net->m ]=AddName( net, net->tn[t], S->names+S->pn[p] );
+        net->mu[ net->m ]=S->mu[p];
+        pmap[p]=net->m;
+      }
+    tbase[k]=net->n; tcnt[k]=S->n;
+    for( i=1; i<=S->n; i++ )
+    {
+      ExpandT( net );
+      net->tn[ ++net->n ]=AddName( net, net->tn[t], S->names+S->tn[i] );
+    }
+    for( i=0; i<S->fapt; i++ )
+    {
+      ExpandApt( net );
+      net->aptp[net->fapt]=pmap[ S->aptp[i] ]; net->aptt[net->fapt]=tbase[k]+S->aptt[i]; net->aptw[net->fapt++]=S->aptw[i];
+    }
+    for( i=0; i<S->fatp; i++ )
+    {
+      ExpandAtp( net );
+      net->atpp[net->fatp]=pmap[ S->atpp[i] ]; net->atpt[net->fatp]=tbase[k]+S->atpt[i]; net->atpw[net->fatp++]=S->atpw[i];
+    }
+    for( i=0; i<S->fatt; i++ )
+    {
+      ExpandAtt( net );
+      net->att1[net->fatt]=tbase[k]+S->att1[i]; net->att2[net->fatt++]=tbase[k]+S->att2[i];
+    }
+    free( pmap );
+  }
+
+  /* remove arcs of substituted transitions, priorities of them are passed to subnet transitions */
+  for( i=0, w=0; i<net->fapt; i++ )
+    if( net->aptt[i]>n0 || !sub[ net->aptt[i] ] )
+      { net->aptp[w]=net->aptp[i]; net->aptt[w]=net->aptt[i]; net->aptw[w++]=net->aptw[i]; }
+  net->fapt=w;
+  for( i=0, w=0; i<net->fatp; i++ )
+    if( net->atpt[i]>n0 || !sub[ net->atpt[i] ] )
+      { net->atpp[w]=net->atpp[i]; net->atpt[w]=net->atpt[i]; net->atpw[w++]=net->atpw[i]; }
+  net->fatp=w;
+  for( i=0, w=0; i<net->fatt; i++ )
+  {
+    u=net->att1[i]; v=net->att2[i];
+    if( ( u>n0 || !sub[u] ) && ( v>n0 || !sub[v] ) ) { net->att1[w]=u; net->att2[w++]=v; continue; }
+    a1=u; a2=u; b1=v; b2=v;
+    if( u<=n0 && sub[u] ) { a1=tbase[sub[u]-1]+1; a2=tbase[sub[u]-1]+tcnt[sub[u]-1]; }
+    if( v<=n0 && sub[v] ) { b1=tbase[sub[v]-1]+1; b2=tbase[sub[v]-1]+tcnt[sub[v]-1]; }
+    for( u=a1; u<=a2; u++ )
+      for( v=b1; v<=b2; v++ )
+      {
+        NetGrow( net, nx, &maxx, "Flatten", &x1, &x2, NULL );
+        x1[nx]=u; x2[nx++]=v;
+      }
+  }
+  net->fatt=w;
+  for( i=0; i<nx; i++ )
+    { ExpandAtt( net ); net->att1[net->fatt]=x1[i]; net->att2[net->fatt++]=x2[i]; }
+  NetFree( net, x1, maxx*sizeof(int) ); NetFree( net, x2, maxx*sizeof(int) );
+
+  /* renumber transitions without substituted ones */
+  tmap=(int*) malloc( (net->n+1)*sizeof(int) );
+  if( tmap==NULL ) NetError( net, 3, "not enough memory (Flatten)" );
+  for( t=1, nt=0; t<=net->n; t++ )
+    if( t<=n0 && sub[t] ) tmap[t]=0; else { tmap[t]=++nt; net->tn[nt]=net->tn[t]; }
+  for( i=0; i<net->fapt; i++ ) net->aptt[i]=tmap[ net->aptt[i] ];
+  for( i=0; i<net->fatp; i++ ) net->atpt[i]=tmap[ net->atpt[i] ];
+  for( i=0; i<net->fatt; i++ ) { net->att1[i]=tmap[ net->att1[i] ]; net->att2[i]=tmap[ net->att2[i] ]; }
+  net->n=nt;
+  net->l=0; net->nhst=0; net->nhmap=0;
+  free( tmap ); free( sub ); free( tbase ); free( tcnt );
+
+} /* Flatten */
+
+/* flattens net read from file NetFileName; subnets are released afterwards */
+void FreeSubnets( struct subnets * c )
+{
+  int k;
+
+  for( k=0; k<c->k; k++ )
+  {
+    FreeInput( c->net[k] ); NetRelease( c->net[k] );
+    free( c->net[k] ); free( c->path[k] );
+  }
+  free( c->path ); free( c->net ); free( c->busy ); free( c );
+
+} /* FreeSubnets */
+
+void FlattenNet( struct net * net, char * NetFileName )
+{
+  net->sub=(struct subnets *) calloc( 1, sizeof(struct subnets) );
+  if( net->sub==NULL ) NetError( net, 3, "not enough memory (FlattenNet)" );
+  Flatten( net, net->sub, NetFileName );
+  FreeSubnets( net->sub );
+  net->sub=NULL;
+
+} /* FlattenNet */
+
+/* renumbers nodes kept by reduction: pmap[p], tmap[t] nonzero for kept nodes get their new numbers;
+   arcs of removed nodes are dropped, kept nodes keep their names and so the original names */
+void RenumberNet( struct net * net, int *pmap, int *tmap )
+{
+  int i, w, p, t, np=0, nt=0;
+
+  pmap[0]=0; tmap[0]=0;
+  for( p=1; p<=net->m; p++ )
+    if( pmap[p] ) { pmap[p]=++np; net->pn[np]=net->pn[p]; net->mu[np]=net->mu[p]; }
+  for( t=1; t<=net->n; t++ )
+    if( tmap[t] ) { tmap[t]=++nt; net->tn[nt]=net->tn[t]; }
+  for( i=0, w=0; i<net->fapt; i++ )
+    if( pmap[ net->aptp[i] ] && tmap[ net->aptt[i] ] )
+      { net->aptp[w]=pmap[ net->aptp[i] ]; net->aptt[w]=tmap[ net->aptt[i] ]; net->aptw[w++]=net->aptw[i]; }
+  net->fapt=w;
+  for( i=0, w=0; i<net->fatp; i++ )
+    if( pmap[ net->atpp[i] ] && tmap[ net->atpt[i] ] )
+      { net->atpp[w]=pmap[ net->atpp[i] ]; net->atpt[w]=tmap[ net->atpt[i] ]; net->atpw[w++]=net->atpw[i]; }
+  net->fatp=w;
+  for( i=0, w=0; i<net->fatt; i++ )
+    if( tmap[ net->att1[i] ] && tmap[ net->att2[i] ] )
+      { net->att1[w]=tmap[ net->att1[i] ]; net->att2[w++]=tmap[ net->att2[i] ]; }
+  net->fatt=w;
+  for( i=0; i<net->nhst; i++ ) net->hst[i]=tmap[ net->hst[i] ];
+  for( i=0; i<net->nhmap; i++ )
+    net->hmap1[i]=( net->hmap1[i]>0 )? pmap[ net->hmap1[i] ]: -pmap[ -net->hmap1[i] ];
+  net->m=np; net->n=nt;
+
+} /* RenumberNet */
+
+/* drops repeated arcs with the same ends setting ap of repetitions to 0; the first arc gets the last weight
+   as GroupArcs keeps it; with inh, inhibitor arcs of weight 0 repeat only inhibitor arcs; returns number of dropped arcs */
+int DropRepeatedArcs( struct net * net, int na, int *ap, int *at, int *aw, int inh )
+{
+  int i, j, q, t, k=0, gend;
+  int *gptr, *order, *first, *last;
+  int nm=( ( net->m > net->n )? net->m: net->n )+1;
+
+  gptr=(int*) calloc( net->n+1, sizeof(int) );
+  order=(int*) malloc( (na+1)*sizeof(int) );
+  first=(int*) malloc( 2*nm*sizeof(int) );
+  last=(int*) calloc( 2*nm, sizeof(int) );
+  if( gptr==NULL || order==NULL || first==NULL || last==NULL ) NetError( net, 3, "not enough memory (DropRepeatedArcs)" );
+
+  for( i=0; i<na; i++ ) gptr[ at[i] ]++;
+  for( t=1; t<=net->n; t++ ) gptr[t]+=gptr[t-1];
+  for( i=na-1; i>=0; i-- ) order[ --gptr[ at[i] ] ]=i;
+  for( t=1; t<=net->n; t++ )
+  {
+    gend=( t<net->n )? gptr[t+1]: na;
+    for( j=gptr[t]; j<gend; j++ )
+    {
+      i=order[j];
+      q=( inh && aw[i]<=0 )? ap[i]+nm: ap[i];
+      if( last[q]!=t ) { last[q]=t; first[q]=i; continue; }
+      if( aw!=NULL ) aw[ first[q] ]=aw[i];
+      ap[i]=0; k++;
+    }
+  }
+  free( gptr ); free( order ); free( first ); free( last );
+  return( k );
+
+} /* DropRepeatedArcs */
+
+/* structural reduction preserving firing of Sleptsov net; repeats until nothing changes:
+   - repeated arcs are merged as GroupArcs does;
+   - a transition is dead if its input place has no producer and less tokens than the arc weight;
+     it is kept when it has priority arcs in both directions, as they are a part of the closure;
+   - places without consumers (nor inhibitor arcs) are removed;
+   - a transition with single input p1 and single output p2 of weight 1 and without priorities,
+     where p1 has no other consumers and p2 no inhibitor arcs, is removed and p1 is fused into p2 with its marking;
+     as the first fireable transition fires, all transitions before it must be such movers: they empty their
+     inputs before any other transition fires, so tokens reach p2 at the same steps of the other transitions;
+   substituted transitions and mapped places of HSN are kept */
+void ReduceNet( struct net * net )
+{
+  int *pmap, *tmap, *cons, *prod, *pptr, *plist, *nin, *nout, *ia, *oa, *prio, *stamp, *inh;
+  int i, j, k, p, t, p1, p2, changed, iter=0;
+  int m0=net->m, n0=net->n, a0=net->fapt+net->fatp+net->fatt, merged=0;
+
+  pmap=(int*) malloc( (net->m+1)*sizeof(int) );
+  tmap=(int*) malloc( (net->n+1)*sizeof(int) );
+  pptr=(int*) malloc( (net->m+2)*sizeof(int) );
+  cons=(int*) malloc( (net->m+1)*sizeof(int) );
+  prod=(int*) malloc( (net->m+1)*sizeof(int) );
+  plist=(int*) malloc( (net->fatp+1)*sizeof(int) );
+  stamp=(int*) calloc( net->n+1, sizeof(int) );
+  nin=(int*) malloc( (net->n+1)*sizeof(int) );
+  nout=(int*) malloc( (net->n+1)*sizeof(int) );
+  ia=(int*) malloc( (net->n+1)*sizeof(int) );
+  oa=(int*) malloc( (net->n+1)*sizeof(int) );
+  prio=(int*) malloc( (net->n+1)*sizeof(int) );
+  inh=(int*) malloc( (net->m+1)*sizeof(int) );
+  if( pmap==NULL || tmap==NULL || cons==NULL || prod==NULL || pptr==NULL || plist==NULL || stamp==NULL ||
+      nin==NULL || nout==NULL || ia==NULL || oa==NULL || prio==NULL || inh==NULL )
+    NetError( net, 3, "not enough memory (ReduceNet)" );
+
+  /* repeated arcs: p->t and t->p keep the last weight, an inhibitor arc is kept once besides a regular one,
+     t->t are counted once */
+  DropRepeatedArcs( net, net->fapt, net->aptp, net->aptt, net->aptw, 1 );
+  DropRepeatedArcs( net, net->fatp, net->atpp, net->atpt, net->atpw, 0 );
+  DropRepeatedArcs( net, net->fatt, net->att1, net->att2, NULL, 0 );
+  for( p=1; p<=net->m; p++ ) pmap[p]=1;
+  for( t=1; t<=net->n; t++ ) tmap[t]=1;
+  RenumberNet( net, pmap, tmap );
+
+  /* nodes of HSN interface are fixed: 2 in pmap, tmap */
+  for( p=1; p<=net->m; p++ ) pmap[p]=1;
+  for( t=1; t<=net->n; t++ ) tmap[t]=1;
+  for( i=0; i<net->nhmap; i++ ) pmap[ abs( net->hmap1[i] ) ]=2;
+  for( i=0; i<net->nhst; i++ ) tmap[ net->hst[i] ]=2;
+
+  do
+  {
+    changed=0; iter++;
+    memset( cons, 0, (net->m+1)*sizeof(int) ); memset( prod, 0, (net->m+1)*sizeof(int) );
+    memset( nin, 0, (net->n+1)*sizeof(int) ); memset( nout, 0, (net->n+1)*sizeof(int) );
+    memset( prio, 0, (net->n+1)*sizeof(int) ); memset( inh, 0, (net->m+1)*sizeof(int) );
+    for( i=0; i<net->fapt; i++ )
+      if( pmap[ net->aptp[i] ] && tmap[ net->aptt[i] ] )
+      {
+        cons[ net->aptp[i] ]++; nin[ net->aptt[i] ]++; ia[ net->aptt[i] ]=i;
+        if( net->aptw[i]<=0 ) inh[ net->aptp[i] ]++;
+      }
+    for( i=0; i<net->fatp; i++ )
+      if( pmap[ net->atpp[i] ] && tmap[ net->atpt[i] ] ) { prod[ net->atpp[i] ]++; nout[ net->atpt[i] ]++; oa[ net->atpt[i] ]=i; }
+    for( i=0; i<net->fatt; i++ )
+      if( tmap[ net->att1[i] ] && tmap[ net->att2[i] ] ) { prio[ net->att1[i] ]|=1; prio[ net->att2[i] ]|=2; }
+
+    /* producers of places */
+    pptr[1]=0;
+    for( p=1; p<=net->m; p++ ) pptr[p+1]=pptr[p]+prod[p];
+    for( i=0; i<net->fatp; i++ )
+      if( pmap[ net->atpp[i] ] && tmap[ net->atpt[i] ] ) plist[ pptr[ net->atpp[i] ]++ ]=i;
+    for( p=net->m+1; p>1; p-- ) pptr[p]=pptr[p-1];
+    pptr[1]=0;
+
+    /* dead transitions */
+    for( i=0; i<net->fapt; i++ )
+    {
+      p=net->aptp[i]; t=net->aptt[i];
+      if( tmap[t]==1 && pmap[p] && net->aptw[i]>0 && prod[p]==0 && net->mu[p]<net->aptw[i] && prio[t]!=3 )
+        { tmap[t]=0; changed=1; }
+    }
+
+    /* places without consumers */
+    for( p=1; p<=net->m; p++ )
+      if( pmap[p]==1 && cons[p]==0 ) { pmap[p]=0; changed=1; }
+
+    /* single-in single-out transitions from the first one on, while all are movers;
+       a place takes part in one fusion per pass */
+    for( t=1; t<=net->n; t++ )
+    {
+      if( tmap[t]==0 ) continue;
+      if( tmap[t]!=1 || nin[t]!=1 || nout[t]!=1 || prio[t] ) break;
+      i=ia[t]; j=oa[t];
+      p1=net->aptp[i]; p2=net->atpp[j];
+      if( net->aptw[i]!=1 || net->atpw[j]!=1 ) break;
+      if( p1==p2 || pmap[p1]!=1 || !pmap[p2] || cons[p1]!=1 || cons[p2]<0 || inh[p2] ) continue;
+      for( k=pptr[p2]; k<pptr[p2+1]; k++ ) stamp[ net->atpt[ plist[k] ] ]=t;
+      for( k=pptr[p1]; k<pptr[p1+1]; k++ )
+        if( stamp[ net->atpt[ plist[k] ] ]==t ) break;
+      if( k<pptr[p1+1] ) continue;
+      for( k=pptr[p1]; k<pptr[p1+1]; k++ ) net->atpp[ plist[k] ]=p2;
+      net->mu[p2]+=net->mu[p1];
+      pmap[p1]=0; tmap[t]=0; cons[p2]=-1;
+      merged++; changed=1;
+    }
+  } while( changed );
+
+  RenumberNet( net, pmap, tmap );
+  if( net->opt.verbose )
+    fprintf( stderr, "reduced in %d passes: m %d->%d n %d->%d arcs %d->%d, %d transitions fused\n",
+             iter, m0, net->m, n0, net->n, a0, net->fapt+net->fatp+net->fatt, merged );
+
+  free( pmap ); free( tmap ); free( cons ); free( prod ); free( pptr ); free( plist ); free( stamp );
+  free( nin ); free( nout ); free( ia ); free( oa ); free( prio ); free( inh );
+
+} /* ReduceNet */
+
+/* renumbers places by permutation pnew[p] of 1..m; names, marking, arcs and HSN mappings follow the places */
+void PermutePlaces( struct net * net, int *pnew )
+{
+  int i, p, *x;
+
+  x=(int*) malloc( ( 2*net->m+2 )*sizeof(int) );
+  if( x==NULL ) NetError( net, 3, "not enough memory (PermutePlaces)" );
+  for( p=1; p<=net->m; p++ ) { x[ 2*pnew[p] ]=net->pn[p]; x[ 2*pnew[p]+1 ]=net->mu[p]; }
+  for( p=1; p<=net->m; p++ ) { net->pn[p]=x[2*p]; net->mu[p]=x[2*p+1]; }
+  free( x );
+  for( i=0; i<net->fapt; i++ ) net->aptp[i]=pnew[ net->aptp[i] ];
+  for( i=0; i<net->fatp; i++ ) net->atpp[i]=pnew[ net->atpp[i] ];
+  for( i=0; i<net->nhmap; i++ )
+    net->hmap1[i]=( net->hmap1[i]>0 )? pnew[ net->hmap1[i] ]: -pnew[ -net->hmap1[i] ];
+
+} /* PermutePlaces */
+
+/* mean span of places of arcs of a transition: max-min number of place */
+double PlaceSpan( struct net * net )
+{
+  int i, t, *lo, *hi;
+  double sum=0;
+
+  lo=(int*) malloc( (net->n+1)*sizeof(int) );
+  hi=(int*) calloc( net->n+1, sizeof(int) );
+  if( lo==NULL || hi==NULL ) NetError( net, 3, "not enough memory (PlaceSpan)" );
+  for( t=1; t<=net->n; t++ ) lo[t]=net->m+1;
+  for( i=0; i<net->fapt; i++ )
+  {
+    t=net->aptt[i];
+    if( net->aptp[i]<lo[t] ) lo[t]=net->aptp[i];
+    if( net->aptp[i]>hi[t] ) hi[t]=net->aptp[i];
+  }
+  for( i=0; i<net->fatp; i++ )
+  {
+    t=net->atpt[i];
+    if( net->atpp[i]<lo[t] ) lo[t]=net->atpp[i];
+    if( net->atpp[i]>hi[t] ) hi[t]=net->atpp[i];
+  }
+  for( t=1; t<=net->n; t++ ) if( hi[t]>=lo[t] ) sum+=hi[t]-lo[t];
+  free( lo ); free( hi );
+  return( ( net->n>0 )? sum/net->n: 0 );
+
+} /* PlaceSpan */
+
+/* breadth-first search of the component of node s, appended to q from k; adjacency lists are sorted
+   by degree, so children of a node come by increasing degree; returns the end of the component in q,
+   *far gets a node of minimal degree of the last level */
+int RCMSearch( int *ptr, int *adj, int *mark, int stamp, int s, int *q, int k, int *far )
+{
+  int h, e, j, v, lstart=k, lend=k+1;
+
+  mark[s]=stamp; q[k]=s; e=k+1;
+  for( h=k; h<e; h++ )
+  {
+    if( h==lend ) { lstart=lend; lend=e; }
+    for( j=ptr[ q[h] ]; j<ptr[ q[h]+1 ]; j++ )
+    {
+      v=adj[j];
+      if( mark[v]!=stamp ) { mark[v]=stamp; q[ e++ ]=v; }
+    }
+  }
+  *far=q[lstart];
+  for( h=lstart; h<lend; h++ )
+    if( ptr[ q[h]+1 ]-ptr[ q[h] ] < ptr[ *far+1 ]-ptr[ *far ] ) *far=q[h];
+  return( e );
+
+} /* RCMSearch */
+
+/* renumbers places by reverse Cuthill-McKee order of the graph of places 0..m-1 and transitions m..m+n-1
+   connected by arcs; each component starts from a pseudo-peripheral node found by repeated searches;
+   transitions keep their numbers, since the VM fires the first fireable one */
+void ReorderNet( struct net * net )
+{
+  int N=net->m+net->n, E=2*(net->fapt+net->fatp);
+  int *ptr, *adj, *sptr, *sadj, *deg, *byd, *cnt, *mark, *q, *pnew;
+  int i, j, k, u, v, s, far, d, maxd=0, stamp=0, np=0;
+  double span0=0;
+
+  if( net->opt.verbose ) span0=PlaceSpan( net );
+  ptr=(int*) calloc( N+2, sizeof(int) );
+  adj=(int*) malloc( (E+1)*sizeof(int) );
+  sptr=(int*) malloc( (N+2)*sizeof(int) );
+  sadj=(int*) malloc( (E+1)*sizeof(int) );
+  deg=(int*) malloc( (N+1)*sizeof(int) );
+  byd=(int*) malloc( (N+1)*sizeof(int) );
+  mark=(int*) calloc( N+1, sizeof(int) );
+  q=(int*) malloc( (N+1)*sizeof(int) );
+  pnew=(int*) malloc( (net->m+1)*sizeof(int) );
+  if( ptr==NULL || adj==NULL || sptr==NULL || sadj==NULL || deg==NULL || byd==NULL || mark==NULL || q==NULL ||
+      pnew==NULL )
+    NetError( net, 3, "not enough memory (ReorderNet)" );
+
+  /* symmetric adjacency of arcs */
+  for( i=0; i<net->fapt; i++ ) { ptr[ net->aptp[i] ]++; ptr[ net->m+net->aptt[i] ]++; }
+  for( i=0; i<net->fatp; i++ ) { ptr[ net->atpp[i] ]++; ptr[ net->m+net->atpt[i] ]++; }
+  for( u=0; u<N; u++ ) { deg[u]=ptr[u+1]; if( deg[u]>maxd ) maxd=deg[u]; }
+  for( u=1; u<=N; u++ ) ptr[u]+=ptr[u-1];
+  for( i=0; i<net->fapt; i++ )
+  {
+    u=net->aptp[i]-1; v=net->m+net->aptt[i]-1;
+    adj[ --ptr[u+1] ]=v; adj[ --ptr[v+1] ]=u;
+  }
+  for( i=0; i<net->fatp; i++ )
+  {
+    u=net->atpp[i]-1; v=net->m+net->atpt[i]-1;
+    adj[ --ptr[u+1] ]=v; adj[ --ptr[v+1] ]=u;
+  }
+  for( u=0; u<N; u++ ) ptr[u]=ptr[u+1];
+  ptr[N]=E;
+
+  /* nodes by increasing degree (stable), then lists sorted by degree of neighbours */
+  cnt=(int*) calloc( maxd+2, sizeof(int) );
+  if( cnt==NULL ) NetError( net, 3, "not enough memory (ReorderNet)" );
+  for( u=0; u<N; u++ ) cnt[ deg[u]+1 ]++;
+  for( d=1; d<=maxd; d++ ) cnt[d]+=cnt[d-1];
+  for( u=0; u<N; u++ ) byd[ cnt[ deg[u] ]++ ]=u;
+  free( cnt );
+  for( u=0; u<=N; u++ ) sptr[u]=ptr[u];
+  for( k=0; k<N; k++ )
+  {
+    v=byd[k];
+    for( j=ptr[v]; j<ptr[v+1]; j++ ) sadj[ sptr[ adj[j] ]++ ]=v;
+  }
+  for( u=0; u<=N; u++ ) sptr[u]=ptr[u];
+
+  /* components by Cuthill-McKee, starting from a pseudo-peripheral node */
+  for( k=0, i=0; i<N; i++ )
+  {
+    u=byd[i];
+    if( mark[u]!=0 ) continue;
+    s=u;
+    for( j=0; j<2; j++ )
+    {
+      RCMSearch( sptr, sadj, mark, --stamp, s, q, k, &far );
+      if( far==s ) break;
+      s=far;
+    }
+    k=RCMSearch( sptr, sadj, mark, 1, s, q, k, &far );
+  }
+
+  /* places in reversed order */
+  for( k=N-1; k>=0; k-- )
+    if( q[k]<net->m ) pnew[ q[k]+1 ]=++np;
+  PermutePlaces( net, pnew );
+  if( net->opt.verbose ) fprintf( stderr, "reordered: mean place span of transitions %.1f -> %.1f\n", span0, PlaceSpan( net ) );
+
+  free( ptr ); free( adj ); free( sptr ); free( sadj ); free( deg ); free( byd ); free( mark ); free( q );
+  free( pnew );
+
+} /* ReorderNet */
+
+/* reference VM of Sleptsov net: a step fires the first fireable transition at its maximal multiplicity;
+   a transition is fireable when it is enabled and no enabled transition has priority over it */
+struct snvm {
+  int m, n, nw;
+  int *iptr, *ip;      /* inhibitor arcs of transitions: places */
+  int *uptr, *up;      /* input arcs of weight 1 */
+  int *wptr, *wp, *ww; /* input arcs of weight >1 */
+  int *dptr, *dp, *dw; /* output arcs */
+  int *rptr, *rt;      /* priority closure: transitions of lower priority */
+  int *cptr, *ct;      /* consumers of places: transitions to check after a place changes */
+  int64_t *mu;         /* marking */
+  int64_t *c;          /* multiplicity of transitions, 0 if disabled */
+  int *blk;            /* number of enabled transitions having priority over transition */
+  uint64_t *fire;      /* fireable transitions: c>0, blk==0 */
+  unsigned *stamp, epoch; /* transitions added to chk in this step */
+  int *chk, nchk;
+  long long steps;
+};
+
+#define VM_UNBOUNDED INT64_MAX
+
+/* maximal multiplicity of transition t; min-reductions are kept branch-free to be vectorized */
+int64_t VMMultiplicity( struct snvm * v, int t )
 {
-  int t; 
-  
-  for( t=1; t<=n; t++ )
+  int64_t c=VM_UNBOUNDED, x, z=0;
+  int k;
+
+  for( k=v->iptr[t]; k<v->iptr[t+1]; k++ ) z|=v->mu[ v->ip[k] ];
+  if( z ) return( 0 );
+  for( k=v->uptr[t]; k<v->uptr[t+1]; k++ ) { x=v->mu[ v->up[k] ]; c=( x<c )? x: c; }
+  for( k=v->wptr[t]; k<v->wptr[t+1]; k++ ) { x=v->mu[ v->wp[k] ]/v->ww[k]; c=( x<c )? x: c; }
+  return( c );
+
+} /* VMMultiplicity */
+
+void VMFireBit( struct snvm * v, int t )
+{
+  if( v->c[t]>0 && v->blk[t]==0 ) v->fire[ t>>6 ]|=((uint64_t)1)<<(t&63);
+    else v->fire[ t>>6 ]&=~(((uint64_t)1)<<(t&63));
+
+} /* VMFireBit */
+
+/* sets multiplicity c of transition t and counts of transitions it has priority over */
+void VMSetMultiplicity( struct snvm * v, int t, int64_t c )
+{
+  int k, d;
+
+  if( (c>0) != (v->c[t]>0) )
   {
-    fprintf( f, "// %d\t%s\n", t-1, names + tn[t] );
+    d=( c>0 )? 1: -1;
+    for( k=v->rptr[t]; k<v->rptr[t+1]; k++ ) { v->blk[ v->rt[k] ]+=d; VMFireBit( v, v->rt[k] ); }
   }
+  v->c[t]=c;
+  VMFireBit( v, t );
 
-}/* WriteNMT_mart_h */
+} /* VMSetMultiplicity */
 
-#define MATRIX_SIZE(d1,d2,t) ((d1)*(d2)*(sizeof(t)))
-#define MOFF(i,j,d1,d2) ((d2)*(i)+(j))
-#define MELT(x,i,j,d1,d2) (*((x)+MOFF(i,j,d1,d2)))
+/* adds consumers of place p to the transitions to check */
+void VMTouch( struct snvm * v, int p )
+{
+  int k, t;
+
+  for( k=v->cptr[p]; k<v->cptr[p+1]; k++ )
+  {
+    t=v->ct[k];
+    if( v->stamp[t]!=v->epoch ) { v->stamp[t]=v->epoch; v->chk[ v->nchk++ ]=t; }
+  }
 
-void prnMartC(FILE * f,int *x,int m,int n)
+} /* VMTouch */
+
+/* splits input arcs of transitions into inhibitor, unit and weighted lists */
+void VMInputs( struct net * net, struct snvm * v, int *bptr, int *bp, int *bw )
 {
-  int i,j;
-  fprintf( f, "%s","{\n");
-  for(i=0;i<m;i++)
+  int t, k, ni=0, nu=0, nx=0;
+
+  for( k=0; k<bptr[v->n]; k++ )
+    if( bw[k]<0 ) ni++; else if( bw[k]==1 ) nu++; else nx++;
+  v->iptr=(int*) malloc( (v->n+1)*sizeof(int) ); v->ip=(int*) malloc( (ni+1)*sizeof(int) );
+  v->uptr=(int*) malloc( (v->n+1)*sizeof(int) ); v->up=(int*) malloc( (nu+1)*sizeof(int) );
+  v->wptr=(int*) malloc( (v->n+1)*sizeof(int) ); v->wp=(int*) malloc( (nx+1)*sizeof(int) );
+  v->ww=(int*) malloc( (nx+1)*sizeof(int) );
+  if( v->iptr==NULL || v->ip==NULL || v->uptr==NULL || v->up==NULL || v->wptr==NULL || v->wp==NULL || v->ww==NULL )
+    NetError( net, 3, "not enough memory (VMInputs)" );
+  ni=nu=nx=0;
+  for( t=0; t<v->n; t++ )
   {
-  	fprintf( f, "%c",'{');
-  	for(j=0;j<n;j++)
-  	{
-  		fprintf( f, "%d",MELT(x,i,j,m,n));
-  		fprintf( f, "%c",(j<n-1)?',':'}');
-	}
-	fprintf( f, "%s",(i<m-1)?",\n":"\n");
+    v->iptr[t]=ni; v->uptr[t]=nu; v->wptr[t]=nx;
+    for( k=bptr[t]; k<bptr[t+1]; k++ )
+      if( bw[k]<0 ) v->ip[ ni++ ]=bp[k];
+        else if( bw[k]==1 ) v->up[ nu++ ]=bp[k];
+        else { v->wp[nx]=bp[k]; v->ww[ nx++ ]=bw[k]; }
   }
-   fprintf( f, "%s","};\n");
-}
+  v->iptr[v->n]=ni; v->uptr[v->n]=nu; v->wptr[v->n]=nx;
 
-// Generate a matrix of priority arc chains. @ 2023 Qing Zhang: zhangq9919@163.com, Dmitry Zaitsev
-void priority_chain(int *R,int n)
-{
- int x, y, z;
-
-    // lower triangle
-    for (x = 0; x < n; x++) {
-        for (y = 0; y < x; y++) {
-            if (MELT(R,x,y,n,n) != 0) {
-                for (z = 0; z < n; z++) {
-                    if (MELT(R,y,z,n,n) != 0) {
-                        MELT(R,x,z,n,n) = 1;
-                    }
-                }
-            }
-        }
-    }
+} /* VMInputs */
 
-    // upper triangle
-    for (x = 0; x < n; x++) {
-        for (y = x + 1; y < n; y++) {
-            if (MELT(R,x,y,n,n) != 0) {
-                for (z = 0; z < n; z++) {
-                    if (MELT(R,y,z,n,n) != 0) {
-                        MELT(R,x,z,n,n)= 1;
-                    }
-                }
-            }
-        }
-    }
-}
-// END: Generate a matrix of priority arc chains. @ 2023 Qing Zhang: zhangq9919@163.com, Dmitry Zaitsev
+/* first fireable transition or -1 */
+int VMChoose( struct snvm * v )
+{
+  int i;
 
+  for( i=0; i<v->nw; i++ )
+    if( v->fire[i] ) return( i*64+__builtin_ctzll( v->fire[i] ) );
+  return( -1 );
 
-void WriteSN_matr_h( FILE * f )
+} /* VMChoose */
+
+/* fires transition t at multiplicity c and checks the consumers of the changed places */
+void VMFire( struct snvm * v, int t )
 {
-  int i,p; 
-  int * x;
-  
-  x=malloc(MATRIX_SIZE(m,n,int));
-   
-  fprintf( f, "// SN obtained from NDR\n");
-  fprintf( f, "#define m %d\n#define n %d\n", m, n);
-  memset(x,0,MATRIX_SIZE(m,n,int));
-  fprintf( f, "// incoming arcs of transitions\nstatic int b[%d][%d]=\n",m,n);
-  for( i=0; i<fapt; i++ )
-    MELT(x,(aptp[i]-1),(aptt[i]-1),m,n)=(aptw[i]>0)?aptw[i]:-1;
-    //fprintf( f, "%d %d %d\n", aptp[i], aptt[i], (aptw[i]>0)?aptw[i]:-1 );
-  prnMartC(f,x,m,n);
- 
-  memset(x,0,MATRIX_SIZE(m,n,int));
-  fprintf( f, "// outgoing arcs of transitions\nstaticint d[%d][%d]=\n",m,n);  
-  for( i=0; i<fatp; i++ )
-    MELT(x,(atpp[i]-1),(atpt[i]-1),m,n)=atpw[i];
-    //fprintf( f, "%d %d %d\n", -atpp[i], atpt[i], atpw[i] );
-  prnMartC(f,x,m,n);
-    
-  /*fprintf( f, "; t->t: -t1 -t2 0\n");    
-  for( i=0; i<fatt; i++ )
-  fprintf( f, "%d %d %d\n", -att1[i], -att2[i], 0 );*/
-    
-  free(x);
-  x=malloc(MATRIX_SIZE(n,n,int));
-  memset(x,0,MATRIX_SIZE(n,n,int));
-  fprintf( f, "// priority arcs connecting transitions, transitive closure\nstaticint r[%d][%d]=\n",n,n);   
-  for( i=0; i<fatt; i++ )
-    MELT(x,(att1[i]-1),(att2[i]-1),n,n)=1;
-    //fprintf( f, "%d %d %d\n", -att1[i], -att2[i], 0 );
-  priority_chain(x,n);  
-  prnMartC(f,x,n,n);
+  int64_t c=v->c[t];
+  int k;
 
-  free(x);
-  fprintf( f, "// initial marking\nstaticint mu[%d]={",m);
-  for( p=1; p<=m; p++ )
+  v->nchk=0; v->epoch++;
+  for( k=v->uptr[t]; k<v->uptr[t+1]; k++ ) { v->mu[ v->up[k] ]-=c; VMTouch( v, v->up[k] ); }
+  for( k=v->wptr[t]; k<v->wptr[t+1]; k++ ) { v->mu[ v->wp[k] ]-=c*v->ww[k]; VMTouch( v, v->wp[k] ); }
+  for( k=v->dptr[t]; k<v->dptr[t+1]; k++ ) { v->mu[ v->dp[k] ]+=c*v->dw[k]; VMTouch( v, v->dp[k] ); }
+  for( k=0; k<v->nchk; k++ ) VMSetMultiplicity( v, v->chk[k], VMMultiplicity( v, v->chk[k] ) );
+
+} /* VMFire */
+
+void VMInit( struct snvm * v, struct net * net )
+{
+  int *bptr, *bp, *bw;
+  int p, t;
+
+  memset( v, 0, sizeof(*v) );
+  v->m=net->m; v->n=net->n; v->nw=(net->n+63)/64;
+  bptr=(int*) malloc( (net->n+1)*sizeof(int) );
+  bp=(int*) malloc( (net->fapt+1)*sizeof(int) );
+  bw=(int*) malloc( (net->fapt+1)*sizeof(int) );
+  v->dptr=(int*) malloc( (net->n+1)*sizeof(int) );
+  v->dp=(int*) malloc( (net->fatp+1)*sizeof(int) );
+  v->dw=(int*) malloc( (net->fatp+1)*sizeof(int) );
+  v->rptr=(int*) malloc( (net->n+1)*sizeof(int) );
+  v->cptr=(int*) calloc( net->m+2, sizeof(int) );
+  v->ct=(int*) malloc( (net->fapt+1)*sizeof(int) );
+  v->mu=(int64_t*) malloc( (net->m+1)*sizeof(int64_t) );
+  v->c=(int64_t*) calloc( net->n+1, sizeof(int64_t) );
+  v->blk=(int*) calloc( net->n+1, sizeof(int) );
+  v->fire=(uint64_t*) calloc( v->nw+1, sizeof(uint64_t) );
+  v->stamp=(unsigned*) calloc( net->n+1, sizeof(unsigned) );
+  v->chk=(int*) malloc( (net->n+1)*sizeof(int) );
+  if( bptr==NULL || bp==NULL || bw==NULL || v->dptr==NULL || v->dp==NULL || v->dw==NULL || v->rptr==NULL ||
+      v->cptr==NULL || v->ct==NULL || v->mu==NULL || v->c==NULL || v->blk==NULL || v->fire==NULL || v->stamp==NULL || v->chk==NULL )
+    NetError( net, 3, "not enough memory (VMInit)" );
+
+  GroupArcs( net, net->fapt, net->aptp, net->aptt, net->aptw, 1, bptr, bp, bw );
+  GroupArcs( net, net->fatp, net->atpp, net->atpt, net->atpw, 0, v->dptr, v->dp, v->dw );
+  PriorityClosureCSR( net, v->rptr, &v->rt );
+  VMInputs( net, v, bptr, bp, bw );
+
+  /* consumers of places, arcs of a transition are unique after grouping */
+  ConsumersCSR( net, bptr, bp, v->cptr, v->ct );
+  free( bptr ); free( bp ); free( bw );
+
+  for( p=0; p<net->m; p++ ) v->mu[p]=net->mu[p+1];
+  for( t=0; t<net->n; t++ ) VMSetMultiplicity( v, t, VMMultiplicity( v, t ) );
+
+} /* VMInit */
+
+void VMFree( struct snvm * v );
+
+/* runs until no transition is fireable or limit of steps; returns 1 if stopped by the limit */
+int VMRun( struct snvm * v, struct net * net, long long limit )
+{
+  int t;
+
+  while( limit==0 || v->steps<limit )
   {
-  	fprintf( f, "%d", mu[p] );
-  	fprintf( f, "%c",(p<m)?',':'}');
+    t=VMChoose( v );
+    if( t<0 ) return( 0 );
+    if( v->c[t]==VM_UNBOUNDED )
+    {
+      VMFree( v );
+      NetError( net, 4, "transition %d %s fires with unbounded multiplicity", t+1, net->names+net->tn[t+1] );
+    }
+    v->steps++;
+    VMFire( v, t );
   }
-  fprintf( f, ";\n");
-      
-  /*if(l>0) 
-  {
-     ProcessHSNlabels( f );
-  }*/
-  
-  fprintf( f, "// Table of places\n// no\tname\n");
-  WriteNMP_matr_h( f );
-  
-  fprintf( f, "// Table of transitions\n// no\tname\n");
-  WriteNMT_matr_h( f );
-  
-  fprintf( f, "// end of SN\n");
+  return( 1 );
 
-}/* WriteSN_matr_h */
+} /* VMRun */
+
+void VMFree( struct snvm * v )
+{
+  free( v->iptr ); free( v->ip ); free( v->uptr ); free( v->up ); free( v->wptr ); free( v->wp ); free( v->ww );
+  free( v->dptr ); free( v->dp ); free( v->dw ); free( v->rptr ); free( v->rt ); free( v->cptr ); free( v->ct );
+  free( v->mu ); free( v->c ); free( v->blk ); free( v->fire ); free( v->stamp ); free( v->chk );
+
+} /* VMFree */
+
+/* runs net and writes the final marking: p mu name */
+void RunNet( struct net * net, struct obuf * f, char * NetFileName )
+{
+  struct snvm v;
+  char buf[ 128 ];
+  double t0, sec;
+  int p, limited;
+
+  if( net->nhst>0 ) NetError( net, 4, "net %s has substitutions, run it with --flatten", NetFileName );
+  OutFmt( f, "; SN run of %s: m %d n %d\n", NetFileName, net->m, net->n );
+  VMInit( &v, net );
+  t0=WallTime();
+  limited=VMRun( &v, net, net->opt.maxsteps );
+  sec=WallTime()-t0;
+
+  snprintf( buf, sizeof(buf), "; %lld steps%s, %.6f s, %.0f steps/s\n", v.steps, limited? " (limit)": "", sec, ( sec>0 )? v.steps/sec: 0.0 );
+  OutStr( f, buf );
+  OutFmt( f, "; final marking: p mu name\n" );
+  for( p=0; p<net->m; p++ )
+    if( v.mu[p]!=0 ) OutFmt( f, "%d %lld %s\n", p+1, (long long) v.mu[p], net->names+net->pn[p+1] );
+  OutFmt( f, "; end of run\n" );
+  fprintf( stderr, "run %s:%s", NetFileName, buf+1 );
+  VMFree( &v );
+
+} /* RunNet */
+
+
+/* starts accounting of a library call: phases, peak storage and clocks t0, c0 */
+void NetStart( struct net * net, double *t0, double *c0 )
+{
+ memset( net->ph, 0, sizeof(net->ph) ); memset( net->cpu, 0, sizeof(net->cpu) );
+ *t0=WallTime(); *c0=( net->opt.stats )? CpuTime(): 0;
+ net->netpeak=net->netmem; net->nreallocs=0; net->reallocbytes=0;
+
+}/* NetStart */
+
+/* parses file NetFileName, or buffer buf of len bytes named NetFileName, and transforms the net by options */
+void ParseNet( struct net * net, char * NetFileName, char * buf, size_t len, int format, double *t0, double *c0 )
+{
+ FreeInput( net );
+ snprintf( net->src, sizeof(net->src), "%s", NetFileName );
+ ReadNetFile( net, NetFileName, buf, len, format, t0, c0 );
+ if( net->opt.flatten && net->nhst>0 ) FlattenNet( net, NetFileName );
+ if( net->opt.reduce ) ReduceNet( net );
+ if( net->opt.reorder ) ReorderNet( net );
+ PhaseEnd( net, PH_HSN, t0, c0 );
+
+}/* ParseNet */
+
+/* writes parsed net as matr, or its run */
+void WriteNet( struct net * net, struct obuf * f, int matr )
+{
+ if( net->opt.run ) RunNet( net, f, net->src );
+   else if( matr==LSN_BINARY ) WriteBLSN( net, f );
+   else if( matr==MATR_MSN ) WriteMSN( net, f );
+   else if( matr==LSN_GROUPED ) WriteLSN_grouped( net, f );
+   else if( matr==MATR_CODE ) WriteSN_code_h( net, f );
+   else if( matr==MATR_SPARSE ) WriteSN_sparse_h( net, f ); 
+   else if( matr && net->opt.transpose ) WriteSN_tmatr_h( net, f );
+   else if( matr ) WriteSN_matr_h( net, f ); else WriteLSN( net, f );
+
+}/* WriteNet */
+
+/* opens output net->out of file FileName */
+void OutBegin( struct net * net, char * FileName )
+{
+ net->out=OutOpen( FileName );
+ if( net->out==NULL ) NetError( net, 2, "error open file %s", FileName );
+
+}/* OutBegin */
+
+/* closes output net->out of file FileName */
+void OutEnd( struct net * net, char * FileName )
+{
+ struct obuf * o=net->out;
+ int err;
+
+ net->nout+=o->total+o->len;
+ net->out=NULL;
+ err=OutClose( o );
+ if( err==3 ) NetError( net, 3, "not enough memory (output)" );
+ if( err ) NetError( net, 2, "error write file %s", FileName );
+
+}/* OutEnd */
+
+/* starts writing of parsed net */
+void WriteStart( struct net * net, double *t0, double *c0 )
+{
+ if( net->names==NULL ) NetError( net, 4, "no net parsed to write" );
+ net->ph[ PH_CLOSURE ]=0; net->ph[ PH_WRITE ]=0; net->cpu[ PH_CLOSURE ]=0; net->cpu[ PH_WRITE ]=0;
+ *t0=WallTime(); *c0=( net->opt.stats )? CpuTime(): 0;
+ net->nout=0;
+
+}/* WriteStart */
 
+void WriteEnd( struct net * net, double *t0, double *c0 )
+{
+ PhaseEnd( net, PH_WRITE, t0, c0 );
+ /* closure runs inside writers */
+ net->ph[ PH_WRITE ]-=net->ph[ PH_CLOSURE ]; net->cpu[ PH_WRITE ]-=net->cpu[ PH_CLOSURE ];
+
+}/* WriteEnd */
 
-int NDRtoLSN( char * NetFileName, char * LSNFileName, int write_name_tables, int matr )
+/* converts one file within context net; arrays of the previous conversion are reused */
+int ConvertNet( struct net * net, char * NetFileName, char * LSNFileName, int write_name_tables, int matr, int format )
 {
  char nFileName[ FILENAMELEN+1 ];
- FILE * NetFile, * LSNFile, * nFile, * OutFile;
- int format;
- int z;
+ double t0, c0;
    
  /* open files */
- if( strcmp( NetFileName, "-" )==0 ) NetFile = stdin;
-   else NetFile = fopen( NetFileName, "r" );
- if( NetFile == NULL ) {printf( "*** error open file %s\n", NetFileName );exit(2);}
- if( strcmp( LSNFileName, "-" )==0 ) LSNFile = stdout;
-   else LSNFile = fopen( LSNFileName, "w" );
- if( LSNFile == NULL ) {printf( "*** error open file %s\n", LSNFileName );exit(2);}
-   
- /* init net size  */
- maxn=nINIT;
- maxm=mINIT; 
- maxl=lINIT;
- maxnames=namesINIT;
- maxatp=atpINIT;
- maxapt=aptINIT;
- maxatp=attINIT;
-
- /* allocate arrays */
- tn = (int*) calloc( maxn, sizeof(int) ); n=0;
- tl = (int*) calloc( maxl, sizeof(int) ); l=0;
- tltn = (int*) calloc( maxl, sizeof(int) ); 
- 
- pn = (int*) calloc( maxm, sizeof(int) ); m=0;
- mu = (int*) calloc( maxm, sizeof(int) );
- 
- names = (char*) calloc( maxnames, sizeof(char) ); fnames=0;
- aptp = (int*) calloc( maxapt, sizeof(int) );
- aptw = (int*) calloc( maxapt, sizeof(int) );
- aptt = (int*) calloc( maxapt, sizeof(int) ); fapt=0;
- atpp = (int*) calloc( maxatp, sizeof(int) );
- atpw = (int*) calloc( maxatp, sizeof(int) );
- atpt = (int*) calloc( maxatp, sizeof(int) ); fatp=0;
- att1 = (int*) calloc( maxatt, sizeof(int) );
- att2 = (int*) calloc( maxatt, sizeof(int) ); fatt=0;
-
- if( tn==NULL || tl==NULL || tltn==NULL ||
-     pn==NULL || 
-     mu==NULL ||
-     names==NULL ||
-     aptp==NULL || aptt==NULL || aptw==NULL ||
-     atpp==NULL || atpt==NULL || atpw==NULL ||
-     att1==NULL || att2==NULL )
-   { printf( "*** not enough memory for net\n" ); return(3); }  
-   
- 
- ReadNDR( NetFile ); 
- 
- if( NetFile != stdin ) fclose( NetFile );
+ NetStart( net, &t0, &c0 );
+ net->nout=0;
+ OutBegin( net, LSNFileName );
+ ParseNet( net, NetFileName, NULL, 0, format, &t0, &c0 );
 
- if( matr) WriteSN_matr_h( LSNFile ); else WriteLSN( LSNFile );
- if( LSNFile != stdout )fclose( LSNFile );
+ WriteNet( net, net->out, matr );
+ OutEnd( net, LSNFileName );
  
  if(write_name_tables)
  {
    sprintf( nFileName, "%s.nmp", LSNFileName );
-   nFile = fopen( nFileName, "w" );
-   if( nFile == NULL ) {printf( "*** error open file %s\n", nFileName );exit(2);}
-   WriteNMP( nFile );
-   fclose( nFile );
+   OutBegin( net, nFileName );
+   WriteNMP( net, net->out );
+   OutEnd( net, nFileName );
  
    sprintf( nFileName, "%s.nmt", LSNFileName );
-   nFile = fopen( nFileName, "w" );
-   if( nFile == NULL ) {printf( "*** error open file %s\n", nFileName );exit(2);}
-   WriteNMT( nFile );
-   fclose( nFile );
+   OutBegin( net, nFileName );
+   WriteNMT( net, net->out );
+   OutEnd( net, nFileName );
  }
+ WriteEnd( net, &t0, &c0 );
 
- free( tn ); free(atpp); free(atpw); free(atpt);
- free( tl ); free( tltn );
- 
- free( pn ); free(aptp); free(aptw); free(aptt);
- 
- free(att1); free(att2);
-  
- free( names );
+ if( net->opt.verbose )
+   fprintf( stderr, "net: m=%d n=%d arcs=%d, input %zu bytes%s, peak net storage %zu bytes, %zu reallocs of %zu bytes\n",
+            net->m, net->n, net->fapt+net->fatp+net->fatt, net->nnames, net->namesmapped? " mapped": "", net->netpeak, net->nreallocs, net->reallocbytes );
+
+ if( net->opt.stats ) StatsReport( net, NetFileName, LSNFileName );
+
+ FreeInput( net );
  
  return(0);
  
-}/* NDRtoLSN */
+}/* ConvertNet */
+
+
+/* generator of benchmark nets as in tina-sleptsov-tests: sequential sums (add), products (mul),
+   polynomials (pol) and matrix products (matrix) are chains of stages z=x+y or z=x*y;
+   a stage copies x and y into its add or mul subnet and moves the result to z;
+   stage places: 0 x, 1 y, 2 z, 3 start, 4 next start, 5.. own places; "~p" is inhibitor arc */
+static char * GenAddCore[]={ "5 ~8 -> 7", "6 ~8 -> 7", "~5 ~6 ~8 9 -> 8", NULL };
+static int GenAddMu[]={ 8, 9, -1 };
+static char * GenMulCore[]={
+  "~8 19 -> 8", "~6 ~8 20 -> 8", "5 ~20 ->", "9 ~20 -> 20",
+  "6*2 ~19 -> 21", "~19 22 -> 19", "6 ~22 24 -> 23", "~22 25 -> 22",
+  "5 ~24 ~25 -> 7 26", "5 ~23 ~25 -> 26", "~25 27 -> 25", "21 ~27 -> 6",
+  "~27 28 -> 27", "26 ~28 -> 5*2", "8 23 ~24 ~28 -> 24 28", "8 ~23 ~28 -> 28", NULL };
+static int GenMulMu[]={ 8, 9, 19, 20, 22, 24, 25, 27, 28, -1 };
+static int GenMulPr[]={ 1,0, 2,3, 4,5, 6,7, 8,10, 9,10, 11,12, 13,14, 13,15, -1 };
+static char * GenStageArcs[]={
+  "0 ~11 -> 5 10", "10 ~12 -> 0", "~0 ~11 12 -> 11", "~10 ~12 13 -> 12",
+  "1 ~15 -> 6 14", "14 ~16 -> 1", "~1 ~15 16 -> 15", "~14 ~16 17 -> 16",
+  "~3 11 15 -> 3", "8 ~13 ~17 -> 13 17",
+  "7 ~18 -> 2", "2 ~9 ->", "~2 ~9 18 -> 9", "4 ~7 ~18 -> 18", NULL };
+static int GenStageMu[]={ 11, 12, 13, 15, 16, 17, 18, -1 };
+
+#define GEN_ADD 0
+#define GEN_MUL 1
+
+struct gen {
+  struct obuf * f;
+  int format;      /* NDR or NET */
+  int np, nt, ns;  /* places, transitions, stages */
+};
+
+int GenPlace( struct gen * g, int mu )
+{
+  if( g->format==NET )
+  {
+    if( mu>0 ) OutFmt( g->f, "pl p%d (%d)\n", g->np, mu ); else OutFmt( g->f, "pl p%d\n", g->np );
+  }
+  else
+    OutFmt( g->f, "p %d.0 %d.0 p%d %d n\n", 40*(g->np%200), 40*(g->np/200), g->np, mu );
+  return( g->np++ );
+
+} /* GenPlace */
+
+/* transition of template "in... -> out..." over stage places q */
+void GenTrans( struct gen * g, char * tmpl, int * q )
+{
+  char * s;
+  int t, p, w, inh, side=0;
+
+  t=g->nt++;
+  if( g->format==NET ) OutFmt( g->f, "tr t%d", t );
+    else OutFmt( g->f, "t %d.0 %d.0 t%d 0 w n\n", 40*(t%200)+20, 40*(t/200)+20, t );
+  for( s=tmpl; *s; )
+  {
+    while( *s==' ' ) s++;
+    if( *s=='\0' ) break;
+    if( s[0]=='-' && s[1]=='>' ) { side=1; s+=2; if( g->format==NET ) OutStr( g->f, " ->" ); continue; }
+    inh=( *s=='~' ); if( inh ) s++;
+    p=q[ strtol( s, &s, 10 ) ];
+    w=1; if( *s=='*' ) w=strtol( s+1, &s, 10 );
+    if( g->format==NET )
+    {
+      OutFmt( g->f, " p%d", p );
+      if( inh ) OutStr( g->f, "?-1" ); else if( w>1 ) OutFmt( g->f, "*%d", w );
+    }
+    else if( side ) OutFmt( g->f, "e t%d p%d %d n\n", t, p, w );
+    else if( inh ) OutFmt( g->f, "e p%d t%d ?-1 n\n", p, t );
+    else OutFmt( g->f, "e p%d t%d %d n\n", p, t, w );
+  }
+  if( g->format==NET ) OutChar( g->f, '\n' );
+
+} /* GenTrans */
+
+/* stage z=x+y or z=x*y started by place start and starting the next stage by place next */
+void GenStage( struct gen * g, int kind, int x, int y, int z, int start, int next )
+{
+  int q[ 32 ], mu[ 32 ], i, own, t0;
+  char ** core;
+  int * coremu;
+
+  core=( kind==GEN_MUL )? GenMulCore: GenAddCore;
+  coremu=( kind==GEN_MUL )? GenMulMu: GenAddMu;
+  own=( kind==GEN_MUL )? 29: 19;
+  memset( mu, 0, sizeof(mu) );
+  for( i=0; coremu[i]>=0; i++ ) mu[ coremu[i] ]=1;
+  for( i=0; GenStageMu[i]>=0; i++ ) mu[ GenStageMu[i] ]=1;
+  q[0]=x; q[1]=y; q[2]=z; q[3]=start; q[4]=next;
+  for( i=5; i<own; i++ ) q[i]=GenPlace( g, mu[i] );
+  t0=g->nt;
+  for( i=0; core[i]!=NULL; i++ ) GenTrans( g, core[i], q );
+  if( kind==GEN_MUL )
+  {
+    for( i=0; GenMulPr[i]>=0; i+=2 )
+      if( g->format==NET ) OutFmt( g->f, "pr t%d > t%d\n", t0+GenMulPr[i], t0+GenMulPr[i+1] );
+        else OutFmt( g->f, "e t%d t%d 1 n\n", t0+GenMulPr[i], t0+GenMulPr[i+1] );
+  }
+  for( i=0; GenStageArcs[i]!=NULL; i++ ) GenTrans( g, GenStageArcs[i], q );
+  g->ns++;
+
+} /* GenStage */
+
+/* next stage computing z=x+y or z=x*y in new place z */
+int GenOp( struct gen * g, int kind, int x, int y )
+{
+  int z;
+
+  z=GenPlace( g, 0 );
+  GenStage( g, kind, x, y, z, g->ns, g->ns+1 );
+  return( z );
+
+} /* GenOp */
+
+/* writes net of family add, mul, pol or matrix of size k; returns number of stages */
+int GenNet( struct net * net, struct obuf * f, int format, char * family, int k )
+{
+  struct gen g;
+  int i, j, h, ns, x, s, *a=NULL, *b=NULL, *term=NULL;
+
+  if( strcmp( family, "add" )==0 || strcmp( family, "mul" )==0 ) ns=k;
+  else if( strcmp( family, "pol" )==0 ) ns=k*(k+1)/2+k;
+  else if( strcmp( family, "matrix" )==0 ) ns=k*k*(2*k-1);
+  else NetError( net, 4, "unknown net family: %s", family );
+  if( k<1 ) NetError( net, 4, "invalid net size: %d", k );
+
+  g.f=f; g.format=format; g.np=0; g.nt=0; g.ns=0;
+  if( format==NET ) OutFmt( f, "net %s_%d\n", family, k );
+  /* stage i is started by place i */
+  for( i=0; i<=ns; i++ ) GenPlace( &g, i>0 );
+
+  if( strcmp( family, "add" )==0 )
+  {
+    x=GenPlace( &g, 1 );
+    for( i=1; i<=k; i++ ) x=GenOp( &g, GEN_ADD, x, GenPlace( &g, i%9+1 ) );
+  }
+  else if( strcmp( family, "mul" )==0 )
+  {
+    x=GenPlace( &g, 2 );
+    for( i=1; i<=k; i++ ) x=GenOp( &g, GEN_MUL, x, GenPlace( &g, 1 ) );
+  }
+  else if( strcmp( family, "pol" )==0 ) /* a_k x^k + ... + a_1 x + a_0 */
+  {
+    term=(int*) malloc( (k+1)*sizeof(int) );
+    if( term==NULL ) NetError( net, 3, "not enough memory (GenNet)" );
+    x=GenPlace( &g, 1 );
+    for( i=k; i>=1; i-- )
+    {
+      term[i]=GenPlace( &g, i%9+1 );
+      for( j=0; j<i; j++ ) term[i]=GenOp( &g, GEN_MUL, term[i], x );
+    }
+    s=term[k];
+    for( i=k-1; i>=1; i-- ) s=GenOp( &g, GEN_ADD, s, term[i] );
+    GenOp( &g, GEN_ADD, s, GenPlace( &g, 1 ) );
+  }
+  else /* matrix: c_ij = sum a_ih b_hj */
+  {
+    a=(int*) malloc( k*k*sizeof(int) ); b=(int*) malloc( k*k*sizeof(int) );
+    if( a==NULL || b==NULL ) NetError( net, 3, "not enough memory (GenNet)" );
+    for( i=0; i<k*k; i++ ) { a[i]=GenPlace( &g, i%3+1 ); b[i]=GenPlace( &g, (i+1)%3+1 ); }
+    for( i=0; i<k; i++ )
+      for( j=0; j<k; j++ )
+      {
+        s=GenOp( &g, GEN_MUL, a[i*k], b[j] );
+        for( h=1; h<k; h++ ) s=GenOp( &g, GEN_ADD, s, GenOp( &g, GEN_MUL, a[i*k+h], b[h*k+j] ) );
+      }
+  }
+  if( format==NDR ) OutFmt( f, "h %s_%d\n", family, k );
+  free( a ); free( b ); free( term );
+  return( g.ns );
+
+} /* GenNet */
+
+
+/* library calls: an error of conversion returns by NetError to the call, which frees what is left open;
+   the parsed net is kept after errors of writing */
+int NetFail( struct net * net, int keep )
+{
+  net->jmpset=0;
+  if( net->out!=NULL ) { OutClose( net->out ); net->out=NULL; }
+  if( net->sub!=NULL ) { FreeSubnets( net->sub ); net->sub=NULL; }
+  FreeParse( net );
+  if( ! keep ) FreeInput( net );
+  return( net->errcode );
+
+} /* NetFail */
+
+void ndrtosn_options_init( struct ndrtosn_options * opt )
+{
+  memset( opt, 0, sizeof(*opt) );
+  opt->bnames=1;
+  opt->nthreads=1;
+
+} /* ndrtosn_options_init */
+
+ndrtosn * ndrtosn_new( struct ndrtosn_options * opt )
+{
+  struct net * net;
+
+  net=(struct net *) malloc( sizeof(struct net) );
+  if( net==NULL ) return( NULL );
+  NetInit( net );
+  if( opt!=NULL ) net->opt=*opt; else ndrtosn_options_init( &net->opt );
+  if( net->opt.nthreads<1 ) net->opt.nthreads=1;
+  return( net );
+
+} /* ndrtosn_new */
+
+void ndrtosn_free( ndrtosn * net )
+{
+  if( net==NULL ) return;
+  FreeInput( net );
+  NetRelease( net );
+  free( net );
+
+} /* ndrtosn_free */
+
+int ndrtosn_parse_file( ndrtosn * net, char * file, int format )
+{
+  double t0, c0;
+
+  if( setjmp( net->jmp ) ) return( NetFail( net, 0 ) );
+  net->jmpset=1; net->errcode=0; net->err[0]='\0';
+  NetStart( net, &t0, &c0 );
+  ParseNet( net, file, NULL, 0, format, &t0, &c0 );
+  net->jmpset=0;
+  return( NDRTOSN_OK );
+
+} /* ndrtosn_parse_file */
+
+int ndrtosn_parse_buffer( ndrtosn * net, char * buf, size_t len, int format, char * name )
+{
+  double t0, c0;
+
+  if( setjmp( net->jmp ) ) return( NetFail( net, 0 ) );
+  net->jmpset=1; net->errcode=0; net->err[0]='\0';
+  NetStart( net, &t0, &c0 );
+  ParseNet( net, ( name!=NULL )? name: "-", buf, len, format, &t0, &c0 );
+  net->jmpset=0;
+  return( NDRTOSN_OK );
+
+} /* ndrtosn_parse_buffer */
+
+int ndrtosn_write_file( ndrtosn * net, char * file, int output )
+{
+  double t0, c0;
+
+  if( setjmp( net->jmp ) ) return( NetFail( net, 1 ) );
+  net->jmpset=1; net->errcode=0; net->err[0]='\0';
+  WriteStart( net, &t0, &c0 );
+  OutBegin( net, file );
+  WriteNet( net, net->out, output );
+  OutEnd( net, file );
+  WriteEnd( net, &t0, &c0 );
+  net->jmpset=0;
+  return( NDRTOSN_OK );
+
+} /* ndrtosn_write_file */
+
+/* the buffer is terminated by '\0' not counted in *len */
+int ndrtosn_write_buffer( ndrtosn * net, int output, char ** buf, size_t * len )
+{
+  struct obuf * o;
+  double t0, c0;
+
+  if( setjmp( net->jmp ) ) return( NetFail( net, 1 ) );
+  net->jmpset=1; net->errcode=0; net->err[0]='\0';
+  WriteStart( net, &t0, &c0 );
+  net->out=OutOpen( NULL );
+  if( net->out==NULL ) NetError( net, 3, "not enough memory (output)" );
+  WriteNet( net, net->out, output );
+  OutChar( net->out, '\0' );
+  if( net->out->err ) NetError( net, 3, "not enough memory (output)" );
+  o=net->out; net->out=NULL;
+  *buf=o->buf; *len=o->len-1; net->nout=o->len-1;
+  free( o );
+  WriteEnd( net, &t0, &c0 );
+  net->jmpset=0;
+  return( NDRTOSN_OK );
+
+} /* ndrtosn_write_buffer */
+
+int ndrtosn_convert( ndrtosn * net, char * in, char * out, int name_tables, int output, int format )
+{
+  if( setjmp( net->jmp ) ) return( NetFail( net, 0 ) );
+  net->jmpset=1; net->errcode=0; net->err[0]='\0';
+  ConvertNet( net, in, out, name_tables, output, format );
+  net->jmpset=0;
+  return( NDRTOSN_OK );
+
+} /* ndrtosn_convert */
+
+/* format other than NDR or NET is taken by extension of file */
+int ndrtosn_generate( ndrtosn * net, char * family, int k, int format, char * file )
+{
+  if( setjmp( net->jmp ) ) return( NetFail( net, 1 ) );
+  net->jmpset=1; net->errcode=0; net->err[0]='\0';
+  net->nout=0;
+  OutBegin( net, file );
+  GenNet( net, net->out, ( format==NET || format==NDR )? format: FileFormat( file ), family, k );
+  OutEnd( net, file );
+  net->jmpset=0;
+  return( NDRTOSN_OK );
+
+} /* ndrtosn_generate */
+
+char * ndrtosn_error( ndrtosn * net )
+{
+  return( net->err );
+
+} /* ndrtosn_error */
+
+/* sizes of the last net parsed, bytes of the last call, phase times of the last conversion */
+void ndrtosn_info( ndrtosn * net, struct ndrtosn_info * info )
+{
+  info->m=net->m; info->n=net->n; info->arcs=net->fapt+net->fatp+net->fatt; info->substitutions=net->nhst;
+  info->bytes_in=net->nnames; info->bytes_out=net->nout;
+  info->load_s=net->ph[ PH_LOAD ]; info->parse_s=net->ph[ PH_PARSE ]; info->hsn_s=net->ph[ PH_HSN ];
+  info->closure_s=net->ph[ PH_CLOSURE ]; info->write_s=net->ph[ PH_WRITE ];
+
+} /* ndrtosn_info */
 
 #ifdef __MAIN__
+/* batch of conversions shared by workers; each worker takes the next job and keeps its own net context */
+struct batch_job {
+  char * in, * out;
+  double sec;
+  int m, n, arcs;
+  int err;
+};
+
+struct batch {
+  struct batch_job * job;
+  int njob, maxjob, next;
+  int matr, format;
+  struct ndrtosn_options * opt;
+  pthread_mutex_t lock;
+};
+
+void AddJob( struct batch * b, char * in, char * out )
+{
+  struct batch_job * nj;
+
+  if( b->njob >= b->maxjob )
+  {
+    b->maxjob=( b->maxjob>0 )? 2*b->maxjob: 64;
+    nj=(struct batch_job *) realloc( b->job, b->maxjob*sizeof(struct batch_job) );
+    if( nj==NULL ) { printf( "*** not enough memory (AddJob)\n" ); exit(3); }
+    b->job=nj;
+  }
+  b->job[ b->njob ].in=in; b->job[ b->njob ].out=out;
+  b->njob++;
+
+} /* AddJob */
+
+/* jobs from manifest lines "input output"; empty lines and lines starting with ';' are skipped */
+void ReadManifest( struct batch * b, char * FileName )
+{
+  FILE * f;
+  char line[ 2*FILENAMELEN+16 ], in[ FILENAMELEN+1 ], out[ FILENAMELEN+1 ];
+
+  f=( strcmp( FileName, "-" )==0 )? stdin: fopen( FileName, "r" );
+  if( f==NULL ) { printf( "*** error open file %s\n", FileName ); exit(2); }
+  while( fgets( line, sizeof(line), f )!=NULL )
+  {
+    if( line[0]==';' ) continue;
+    if( sscanf( line, "%256s %256s", in, out )!=2 ) continue;
+    AddJob( b, strdup( in ), strdup( out ) );
+  }
+  if( f!=stdin ) fclose( f );
+
+} /* ReadManifest */
+
+/* jobs for all .ndr and .net files of directory; output is placed beside with extension ext */
+void ReadDirectory( struct batch * b, char * DirName, char * ext )
+{
+  DIR * d;
+  struct dirent * e;
+  char * in, * out;
+  int z;
+
+  d=opendir( DirName );
+  if( d==NULL ) { printf( "*** error open directory %s\n", DirName ); exit(2); }
+  while( ( e=readdir( d ) )!=NULL )
+  {
+    z=strlen( e->d_name );
+    if( z<=4 || ( strcmp( e->d_name+z-4, ".ndr" )!=0 && strcmp( e->d_name+z-4, ".net" )!=0 ) ) continue;
+    in=(char*) malloc( strlen( DirName )+z+2 );
+    out=(char*) malloc( strlen( DirName )+z+strlen( ext )+2 );
+    if( in==NULL || out==NULL ) { printf( "*** not enough memory (ReadDirectory)\n" ); exit(3); }
+    sprintf( in, "%s/%s", DirName, e->d_name );
+    sprintf( out, "%s/%.*s%s", DirName, z-4, e->d_name, ext );
+    AddJob( b, in, out );
+  }
+  closedir( d );
+
+} /* ReadDirectory */
+
+void * batch_worker( void * arg )
+{
+  struct batch * b=(struct batch *) arg;
+  struct batch_job * j;
+  struct ndrtosn_info info;
+  ndrtosn * net;
+  double t0;
+  int k;
+
+  net=ndrtosn_new( b->opt );
+  if( net==NULL ) { printf( "*** not enough memory (batch_worker)\n" ); exit(3); }
+  for(;;)
+  {
+    pthread_mutex_lock( &b->lock );
+    k=b->next++;
+    pthread_mutex_unlock( &b->lock );
+    if( k >= b->njob ) break;
+    j=b->job+k;
+    t0=WallTime();
+    j->err=ndrtosn_convert( net, j->in, j->out, 0, b->matr, b->format );
+    j->sec=WallTime()-t0;
+    if( j->err ) { pthread_mutex_lock( &b->lock ); printf( "*** %s: %s\n", j->in, ndrtosn_error( net ) ); pthread_mutex_unlock( &b->lock ); }
+    ndrtosn_info( net, &info );
+    j->m=info.m; j->n=info.n; j->arcs=info.arcs;
+  }
+  ndrtosn_free( net );
+  return( NULL );
+
+} /* batch_worker */
+
+/* converts all jobs on nw workers and prints the summary of times on stderr; returns error code of a failed job */
+int RunBatch( struct batch * b, int nw )
+{
+  pthread_t * th;
+  double t0, sum=0;
+  int i, err=0, nerr=0;
+
+  if( nw > b->njob ) nw=b->njob;
+  if( nw < 1 ) nw=1;
+  th=(pthread_t *) malloc( nw*sizeof(pthread_t) );
+  if( th==NULL ) { printf( "*** not enough memory (RunBatch)\n" ); exit(3); }
+  pthread_mutex_init( &b->lock, NULL );
+  b->next=0;
+  t0=WallTime();
+  for( i=0; i<nw; i++ )
+    if( pthread_create( th+i, NULL, batch_worker, b )!=0 ) { printf( "*** error create thread\n" ); exit(3); }
+  for( i=0; i<nw; i++ ) pthread_join( th[i], NULL );
+  t0=WallTime()-t0;
+  pthread_mutex_destroy( &b->lock );
+  free( th );
+
+  fprintf( stderr, "; time,s m n arcs input output\n" );
+  for( i=0; i<b->njob; i++ )
+  {
+    if( b->job[i].err ) { err=b->job[i].err; nerr++; continue; }
+    fprintf( stderr, "%.6f %d %d %d %s %s\n", b->job[i].sec, b->job[i].m, b->job[i].n, b->job[i].arcs, b->job[i].in, b->job[i].out );
+    sum+=b->job[i].sec;
+  }
+  fprintf( stderr, "; %d files on %d workers: %.6f s wall, %.6f s sum of files\n", b->njob, nw, t0, sum );
+  if( nerr>0 ) fprintf( stderr, "; %d files failed\n", nerr );
+  return( err );
+
+} /* RunBatch */
+
+/* times conversions of generated nets of family for comma separated sizes, writes lines of results */
+int Bench( ndrtosn * net, char * family, char * sizes, char * ResFileName )
+{
+  static int modes[]={ 0, MATR_SPARSE, LSN_BINARY, MATR_MSN, MATR_CODE, MATR_DENSE };
+  static char * mname[]={ "lsn", "sparse", "binary", "msn", "code", "dense" };
+  static char * fname[]={ "", "ndr", "net" };
+  struct ndrtosn_info info;
+  struct obuf * res;
+  char tmp[ FILENAMELEN+1 ], line[ 512 ], * s, * tdir;
+  int k, fmt, i, err;
+  double t0, tgen;
+  size_t nin;
+
+  res=OutOpen( ResFileName );
+  if( res==NULL ) { printf( "*** error open file %s\n", ResFileName ); return(2); }
+  OutStr( res, "family,size,input,output,m,n,arcs,bytes_in,bytes_out,gen_s,load_s,parse_s,hsn_s,closure_s,write_s,total_s\n" );
+  tdir=getenv( "TMPDIR" ); if( tdir==NULL ) tdir="/tmp";
+  info.m=0; info.n=0;
+  for( s=sizes; *s; )
+  {
+    k=strtol( s, &s, 10 );
+    if( *s==',' ) s++;
+    for( fmt=NDR; fmt<=NET; fmt++ )
+    {
+      snprintf( tmp, sizeof(tmp), "%s/NDRtoSN_bench_%d.%s", tdir, (int)getpid(), fname[fmt] );
+      t0=WallTime();
+      err=ndrtosn_generate( net, family, k, fmt, tmp );
+      if( err ) { printf( "*** %s\n", ndrtosn_error( net ) ); unlink( tmp ); OutClose( res ); return( err ); }
+      ndrtosn_info( net, &info );
+      nin=info.bytes_out;
+      tgen=WallTime()-t0;
+      for( i=0; i<6; i++ )
+      {
+        /* dense matrices are written for small nets only */
+        if( modes[i]==MATR_DENSE && (double)info.m*info.n > (1<<24) ) continue;
+        err=ndrtosn_convert( net, tmp, "/dev/null", 0, modes[i], fmt );
+        if( err ) { printf( "*** %s\n", ndrtosn_error( net ) ); continue; }
+        ndrtosn_info( net, &info );
+        snprintf( line, sizeof(line), "%s,%d,%s,%s,%d,%d,%d,%zu,%zu,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f,%.6f\n",
+                  family, k, fname[fmt], mname[i], info.m, info.n, info.arcs, nin, info.bytes_out, tgen,
+                  info.load_s, info.parse_s, info.hsn_s, info.closure_s, info.write_s,
+                  info.load_s+info.parse_s+info.hsn_s+info.closure_s+info.write_s );
+        OutStr( res, line );
+        OutFlush( res );
+      }
+      unlink( tmp );
+    }
+  }
+  return( OutClose( res ) );
+
+} /* Bench */
+
 static char Help[] =
 "NDRtoSN - version 2.0.2\n\n"
-"action: converts .ndr file to either .lsn/.hsn or C language header .h\n"
-"file formats: .ndr, .net (www.laas.fr/tina), .lsn/.hsn, C header .h\n"
+"action: converts .ndr/.net/binary .lsn file to either .lsn/.hsn, binary .lsn or C language header .h\n"
+"file formats: .ndr, .net (www.laas.fr/tina), .lsn/.hsn, binary .lsn, C header .h\n"
 "usage:   NDRtoSN [-h]\n"
-"                 [-l/-c]\n"
-"                 ndr_file lsn_hsn_file/c_header_file\n"
+"                 [-l/-lg [--offsets]/-c/-s/-cg/-b/-bn/-msn]\n"
+"                 [--deps] [--narrow/--progmem] [--transpose]\n"
+"                 [-d/-n/-u]\n"
+"                 [-pb] [-j threads] [-v] [--stats/--stats-json] [--flatten] [--reduce] [--reorder] [--run [--steps N]]\n"
+"                 [-w workers] [-m manifest] [-D directory]\n"
+"                 [-g family size] [-bench family sizes]\n"
+"                 ndr_file lsn_hsn_file/c_header_file [ndr_file lsn_hsn_file/c_header_file ...]\n"
 "FLAGS            WHAT                                          DEFAULT\n"
 "-h               print help (this text)\n"
 "-l               output as .lsn/.hsn                           -l\n"
 "-c               output as C header\n" 
-"ndr_file         Sleptsov/Petri net in .ndr format\n"
+"-s               output as C header with sparse arc arrays\n"
+"-b               output as binary .lsn with names\n"
+"-bn              output as binary .lsn without names\n"
+"-msn             output as MSN matrices for SN-VM-GPU\n"
+"-cg              output as C header of firing code of transitions\n"
+"-lg              output as LSN with arcs grouped by transition, repeated arcs merged\n"
+"--offsets        -lg with \";@ t b d r\" offsets of arcs of transitions\n"
+"--deps           index of transitions depending on places in LSN and C headers\n"
+"--narrow         narrowest fixed-width types of tables in C header, size report\n"
+"--progmem        --narrow with constant tables in flash (const, PROGMEM)\n"
+"--transpose      -c with transition rows of places padded and aligned, inhibitor bit rows\n"
+"-d               input in .ndr format                          by extension\n"
+"-n               input in .net format\n"
+"-u               input in binary .lsn format                   by magic\n"
+"-pb              priority closure as packed bit rows in C header\n"
+"-j threads       number of threads for parse, priority closure 1\n"
+"-v               report net size and peak storage on stderr\n"
+"--flatten        substitute subnets from files name[.lsn/.hsn/.ndr/.net] into flat LSN\n"
+"--reduce         remove repeated arcs, dead transitions, places without consumers, fuse chains\n"
+"--reorder        renumber places by reverse Cuthill-McKee for locality\n"
+"--run            run net by reference VM and write its final marking instead of the net\n"
+"--steps N        run at most N steps\n"
+"--stats          report phase times, bytes, net size and memory on stderr\n"
+"--stats-json     the report as JSON in output_file.stats.json\n"
+"-w workers       number of threads for batch of files          cores\n"
+"-m manifest      batch of lines \"input output\" (- stdin)\n"
+"-D directory     batch of all .ndr/.net files of directory\n"
+"-g family size   generate net add/mul/pol/matrix of size into .ndr/.net file\n"
+"-bench family sizes  time phases of conversion of generated nets of sizes 10,20,...\n"
+"                 and write results as comma separated values into file (- stdout)\n"
+"ndr_file         Sleptsov/Petri net in .ndr or .net format\n"
 "lsn_or_hsn_file  Sleptsov/Petri net in .lsn or .hsn format\n"
 "c_header_file    Sleptsov/Petri as C language header\n\n"
 "@ 2024 Dmitry Zaitsev, daze@acm.org\n";
 int main( int argc, char *argv[] )
 {
-  char * InFileName;
-  char * OutFileName;
-  int i, numf=0, c_headers=0;
+  char * InFileName="-";
+  char * OutFileName="-";
+  char * manifest=NULL, * dir=NULL, * family=NULL, * sizes=NULL;
+  int i, numf=0, c_headers=0, format=0, workers=0, gsize=0, err;
+  struct ndrtosn_options opt;
+  struct batch b;
+  ndrtosn * net;
+  
+    memset( &b, 0, sizeof(b) );
+    ndrtosn_options_init( &opt );
   
     /* parse command line */
     numf=0;
@@ -952,21 +4958,74 @@ int main( int argc, char *argv[] )
         printf( "%s", Help ); return( 0);
       }
       
-      else if( strcmp( argv[i], "-c" )==0 ) c_headers=1;
+      else if( strcmp( argv[i], "-c" )==0 ) c_headers=MATR_DENSE;
+      else if( strcmp( argv[i], "-s" )==0 ) c_headers=MATR_SPARSE;
       else if( strcmp( argv[i], "-l" )==0 ) c_headers=0;
+      else if( strcmp( argv[i], "-d" )==0 ) format=NDR;
+      else if( strcmp( argv[i], "-b" )==0 ) { c_headers=LSN_BINARY; opt.bnames=1; }
+      else if( strcmp( argv[i], "-bn" )==0 ) { c_headers=LSN_BINARY; opt.bnames=0; }
+      else if( strcmp( argv[i], "-msn" )==0 ) c_headers=MATR_MSN;
+      else if( strcmp( argv[i], "-lg" )==0 ) c_headers=LSN_GROUPED;
+      else if( strcmp( argv[i], "-cg" )==0 ) c_headers=MATR_CODE;
+      else if( strcmp( argv[i], "--offsets" )==0 ) { c_headers=LSN_GROUPED; opt.offsets=1; }
+      else if( strcmp( argv[i], "-n" )==0 ) format=NET;
+      else if( strcmp( argv[i], "-u" )==0 ) format=BLSN;
+      else if( strcmp( argv[i], "-pb" )==0 ) opt.rbits=1;
+      else if( strcmp( argv[i], "--deps" )==0 ) opt.deps=1;
+      else if( strcmp( argv[i], "--narrow" )==0 ) opt.narrow=1;
+      else if( strcmp( argv[i], "--transpose" )==0 ) { c_headers=MATR_DENSE; opt.transpose=1; }
+      else if( strcmp( argv[i], "--progmem" )==0 ) opt.narrow=opt.progmem=1;
+      else if( strcmp( argv[i], "-v" )==0 ) opt.verbose=1;
+      else if( strcmp( argv[i], "--stats" )==0 ) opt.stats=1;
+      else if( strcmp( argv[i], "--flatten" )==0 ) opt.flatten=1;
+      else if( strcmp( argv[i], "--reduce" )==0 ) opt.reduce=1;
+      else if( strcmp( argv[i], "--reorder" )==0 ) opt.reorder=1;
+      else if( strcmp( argv[i], "--run" )==0 ) opt.run=1;
+      else if( strcmp( argv[i], "--steps" )==0 && i+1<argc ) { opt.run=1; opt.maxsteps=atoll( argv[++i] ); }
+      else if( strcmp( argv[i], "--stats-json" )==0 ) opt.stats=2;
+      else if( strcmp( argv[i], "-j" )==0 && i+1<argc ) { opt.nthreads=atoi( argv[++i] ); if( opt.nthreads<1 ) opt.nthreads=1; }
+      else if( strcmp( argv[i], "-w" )==0 && i+1<argc ) workers=atoi( argv[++i] );
+      else if( strcmp( argv[i], "-m" )==0 && i+1<argc ) manifest=argv[++i];
+      else if( strcmp( argv[i], "-D" )==0 && i+1<argc ) dir=argv[++i];
+      else if( strcmp( argv[i], "-g" )==0 && i+2<argc ) { family=argv[++i]; gsize=atoi( argv[++i] ); }
+      else if( strcmp( argv[i], "-bench" )==0 && i+2<argc ) { family=argv[++i]; sizes=argv[++i]; }
+      else if( argv[i][0]=='-' && argv[i][1]!='\0' )
+        { printf( "*** unknown option: %s\n", argv[i] ); return(4); }
       
       else if( numf==0 ) { InFileName=argv[i]; numf++; }
       else if( numf==1 ) { OutFileName=argv[i]; numf++; }
       else
-        { printf( "*** unknown option: %s\n", argv[i] ); return(4); }
+      {
+        if( numf==2 ) AddJob( &b, InFileName, OutFileName );
+        if( i+1>=argc ) { printf( "*** no output file for %s\n", argv[i] ); return(4); }
+        AddJob( &b, argv[i], argv[i+1] ); i++; numf+=2;
+      }
     } /* for */
   
-    if( numf==0 ) InFileName = "-";
-    if( numf<=1 ) OutFileName = "-";
-   
-    NDRtoLSN( InFileName, OutFileName, 0, c_headers);
+    if( manifest!=NULL || dir!=NULL || ( numf>2 && family==NULL ) )
+    {
+      if( numf==2 ) AddJob( &b, InFileName, OutFileName );
+      if( manifest!=NULL ) ReadManifest( &b, manifest );
+      if( dir!=NULL ) ReadDirectory( &b, dir, ( c_headers==LSN_BINARY )? ".bsn": ( c_headers==MATR_MSN )? ".msn": ( c_headers && c_headers!=LSN_GROUPED )? ".h": ".lsn" );
+      b.matr=c_headers; b.format=format; b.opt=&opt;
+      if( workers<1 ) workers=sysconf( _SC_NPROCESSORS_ONLN );
+      return( RunBatch( &b, workers ) );
+    }
+
+    net=ndrtosn_new( &opt );
+    if( net==NULL ) { printf( "*** not enough memory (main)\n" ); return(3); }
+    if( family!=NULL && sizes!=NULL )
+      err=Bench( net, family, sizes, InFileName );
+    else if( family!=NULL )
+      err=ndrtosn_generate( net, family, gsize, format, InFileName );
+    else
+    {
+      err=ndrtosn_convert( net, InFileName, OutFileName, 0, c_headers, format );
+    }
+    if( err && ndrtosn_error( net )[0]!='\0' ) printf( "*** %s\n", ndrtosn_error( net ) );
+    ndrtosn_free( net );
    
-  return(0);
+  return( err );
   
 } /* main */
 
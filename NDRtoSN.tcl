@@ -1,7 +1,7 @@
 namespace eval NDRtoSN {
 
     proc controls {} {
-	radiobox NDRtoSN::format "output format" ".lsn/.hsn .h" "-l -c" -c
+	radiobox NDRtoSN::format "output format" ".lsn/.hsn .h sparse.h" "-l -c -s" -c
     }
 
     proc command {} {
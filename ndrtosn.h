@@ -0,0 +1,111 @@
+// ndrtosn.h
+//
+// libndrtosn: converts Sleptsov/Petri nets .ndr, .net, .lsn/.hsn and binary .lsn
+// into .lsn/.hsn, binary .lsn, MSN matrices, C language headers or firing code
+//
+// A context ndrtosn keeps all the state of conversions: contexts are used by
+// different threads concurrently, one context by one thread at a time.
+// Calls return NDRTOSN_OK or an error code, the message is ndrtosn_error().
+//
+// Build, the repository has no build system and these lines are its static and shared library targets:
+//        gcc -O2 -c -DNDRTOSN_LIB NDRtoSN.c -o ndrtosn.o && ar rcs libndrtosn.a ndrtosn.o
+//        gcc -O2 -fPIC -shared -fvisibility=hidden -DNDRTOSN_LIB -o libndrtosn.so NDRtoSN.c -lpthread
+//
+
+#ifndef NDRTOSN_H
+#define NDRTOSN_H
+
+#include <stddef.h>
+
+#if defined(__GNUC__)
+#define NDRTOSN_API __attribute__((visibility("default")))
+#else
+#define NDRTOSN_API
+#endif
+
+/* error codes, the same as exit codes of NDRtoSN */
+#define NDRTOSN_OK 0
+#define NDRTOSN_EFILE 2    /* file, or format of input */
+#define NDRTOSN_EMEMORY 3  /* not enough memory, or threads */
+#define NDRTOSN_EUSAGE 4   /* net unsuitable for the request */
+
+/* input formats, 0 - by magic or file extension */
+#define NDRTOSN_NDR 1
+#define NDRTOSN_NET 2
+#define NDRTOSN_BLSN 3
+#define NDRTOSN_LSN 4
+
+/* outputs */
+#define NDRTOSN_OUT_LSN 0      /* .lsn/.hsn */
+#define NDRTOSN_OUT_DENSE 1    /* C header */
+#define NDRTOSN_OUT_SPARSE 2   /* C header with sparse arc arrays */
+#define NDRTOSN_OUT_BINARY 3   /* binary .lsn */
+#define NDRTOSN_OUT_MSN 4      /* MSN matrices for SN-VM-GPU */
+#define NDRTOSN_OUT_GROUPED 5  /* .lsn with arcs grouped by transition */
+#define NDRTOSN_OUT_CODE 6     /* C header of firing code of transitions */
+
+/* options of conversion, the command line flags of NDRtoSN */
+struct ndrtosn_options {
+  int verbose;   /* -v: net size and peak storage on stderr */
+  int bnames;    /* binary .lsn with string table (-b), without (-bn) */
+  int stats;     /* --stats: 1 text report on stderr, 2 JSON sidecar */
+  int flatten;   /* --flatten: substitute subnets into flat .lsn */
+  int reduce;    /* --reduce: structural reduction before writing */
+  int reorder;   /* --reorder: renumber nodes by reverse Cuthill-McKee */
+  int offsets;   /* --offsets: grouped .lsn with offsets of arcs of transitions */
+  int run;       /* --run: write final marking of run by reference VM instead of net */
+  long long maxsteps; /* --steps: limit of steps of run, 0 none */
+  int nthreads;  /* -j: threads of parse, priority closure and VM */
+  int rbits;     /* -pb: closure as packed bit rows in C header */
+  int deps;      /* --deps: index of transitions depending on places in LSN and C headers */
+  int narrow;    /* --narrow: narrowest fixed-width types of tables in C header */
+  int progmem;   /* --progmem: constant tables of C header in flash, needs narrow */
+  int transpose; /* --transpose: dense C header of transition rows, padded and aligned */
+};
+
+/* net and times of the last conversion */
+struct ndrtosn_info {
+  int m, n, arcs, substitutions;
+  size_t bytes_in, bytes_out;
+  double load_s, parse_s, hsn_s, closure_s, write_s;
+};
+
+typedef struct net ndrtosn;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* defaults: binary .lsn with names, 1 thread */
+NDRTOSN_API void ndrtosn_options_init( struct ndrtosn_options * opt );
+
+/* new context with options opt (NULL - defaults); NULL if not enough memory */
+NDRTOSN_API ndrtosn * ndrtosn_new( struct ndrtosn_options * opt );
+NDRTOSN_API void ndrtosn_free( ndrtosn * net );
+
+/* parse net of format (0 - by magic or extension of file) and transform it by options;
+   the net is kept in the context until the next parse; file "-" is stdin */
+NDRTOSN_API int ndrtosn_parse_file( ndrtosn * net, char * file, int format );
+/* buf of len bytes is copied; name is used for subnets and reports */
+NDRTOSN_API int ndrtosn_parse_buffer( ndrtosn * net, char * buf, size_t len, int format, char * name );
+
+/* write parsed net as output NDRTOSN_OUT_*, or its run with option run; file "-" is stdout */
+NDRTOSN_API int ndrtosn_write_file( ndrtosn * net, char * file, int output );
+/* *buf of *len bytes is allocated by malloc and freed by the caller */
+NDRTOSN_API int ndrtosn_write_buffer( ndrtosn * net, int output, char ** buf, size_t * len );
+
+/* parse in and write out, with tables of names out.nmp and out.nmt when name_tables */
+NDRTOSN_API int ndrtosn_convert( ndrtosn * net, char * in, char * out, int name_tables, int output, int format );
+
+/* write benchmark net of family add, mul, pol or matrix of size k in format NDRTOSN_NDR or NDRTOSN_NET */
+NDRTOSN_API int ndrtosn_generate( ndrtosn * net, char * family, int k, int format, char * file );
+
+/* message of the last error */
+NDRTOSN_API char * ndrtosn_error( ndrtosn * net );
+NDRTOSN_API void ndrtosn_info( ndrtosn * net, struct ndrtosn_info * info );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
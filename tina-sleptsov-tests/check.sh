@@ -0,0 +1,65 @@
+#!/bin/sh
+# checks of NDRtoSN on the nets of this directory and the .ndr samples of the repository:
+#   reduce - --run gives the same final marking with and without --reduce on the places the reduced net keeps
+#   grouped - LSN of -lg, read back, runs to the same final marking as the net
+#   reorder - --run gives the same final marking by names of places with and without --reorder
+#   parse - LSN of the parallel parse by -j 4, with chunks of 64 bytes, is the same as of the sequential one
+#   blsn - binary LSN with names (-b), read back, gives the same LSN as the net
+# usage: sh check.sh; NDRtoSN is built from ../NDRtoSN.c by $CC (gcc), one line is printed per check,
+# the exit code is 1 when a check fails
+
+cd "$(dirname "$0")" || exit 2
+CC=${CC:-gcc}
+tmp=$(mktemp -d) || exit 2
+trap 'rm -rf "$tmp"' EXIT
+$CC -O2 -o "$tmp/NDRtoSN" ../NDRtoSN.c -lpthread || exit 2
+$CC -O2 -DPARSE_CHUNK=64 -o "$tmp/NDRtoSN_p" ../NDRtoSN.c -lpthread || exit 2
+fail=0
+
+check() # name result
+{
+  if [ "$2" = 0 ]; then echo "ok   $1"; else echo "FAIL $1"; fail=1; fi
+}
+
+for f in *.net ../*.ndr; do
+  b=$(basename "$f")
+
+  # reduce: markings of the kept places, absent lines are 0
+  "$tmp/NDRtoSN" --run "$f" "$tmp/o.run" >/dev/null 2>&1 &&
+  "$tmp/NDRtoSN" --run --reduce "$f" "$tmp/r.run" >/dev/null 2>&1 &&
+  "$tmp/NDRtoSN" -l --reduce "$f" "$tmp/r.lsn" >/dev/null 2>&1 &&
+  awk 'FNR==1 { f++ }
+       f<3 && /^[0-9]/ { mu[f, $3]=$2 }
+       f==3 && /^; Table of places/ { s=1; next }
+       f==3 && /^; Table of transitions/ { s=0 }
+       f==3 && s && /^; [0-9]/ { kept[$3]=1 }
+       END { for( p in kept ) if( mu[1, p]+0 != mu[2, p]+0 ) { print p; bad=1 }; exit bad }' \
+    "$tmp/o.run" "$tmp/r.run" "$tmp/r.lsn" >/dev/null
+  check "reduce $b" $?
+
+  # grouped: the lines of the final marking are the same
+  "$tmp/NDRtoSN" -lg "$f" "$tmp/g.lsn" >/dev/null 2>&1 &&
+  "$tmp/NDRtoSN" --run "$tmp/g.lsn" "$tmp/g.run" >/dev/null 2>&1 &&
+  grep -v '^;' "$tmp/o.run" >"$tmp/o.mu" && grep -v '^;' "$tmp/g.run" >"$tmp/g.mu" &&
+  cmp -s "$tmp/o.mu" "$tmp/g.mu"
+  check "grouped $b" $?
+
+  # reorder: places are renumbered, so the markings are compared by names
+  "$tmp/NDRtoSN" --run --reorder "$f" "$tmp/q.run" >/dev/null 2>&1 &&
+  awk '!/^;/ { print $3, $2 }' "$tmp/o.run" | sort >"$tmp/o.nmu" &&
+  awk '!/^;/ { print $3, $2 }' "$tmp/q.run" | sort >"$tmp/q.nmu" &&
+  cmp -s "$tmp/o.nmu" "$tmp/q.nmu"
+  check "reorder $b" $?
+
+  "$tmp/NDRtoSN" -l "$f" "$tmp/s.lsn" >/dev/null 2>&1 &&
+  "$tmp/NDRtoSN_p" -j 4 -l "$f" "$tmp/p.lsn" >/dev/null 2>&1 &&
+  cmp -s "$tmp/s.lsn" "$tmp/p.lsn"
+  check "parse $b" $?
+
+  "$tmp/NDRtoSN" -b "$f" "$tmp/b.bsn" >/dev/null 2>&1 &&
+  "$tmp/NDRtoSN" -l "$tmp/b.bsn" "$tmp/b.lsn" >/dev/null 2>&1 &&
+  cmp -s "$tmp/s.lsn" "$tmp/b.lsn"
+  check "blsn $b" $?
+done
+
+exit $fail